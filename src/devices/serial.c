@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -37,6 +37,9 @@
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable receive and transmit FIFOs. */
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03            /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80           /* Divisor Latch Access Bit (DLAB). */
@@ -47,15 +50,33 @@
 /* Line Status Register. */
 #define LSR_DR 0x01             /* Data Ready: received data byte is in RBR. */
 #define LSR_THRE 0x20           /* THR Empty. */
+#define LSR_TEMT 0x40           /* Transmitter empty, THR and shift reg. */
+
+/* Bytes the transmit FIFO holds when THR Empty is set. */
+#define XMIT_FIFO_SIZE 16
 
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Data to be transmitted.  This is big enough that a burst of
+   console output can be copied in at once and then drained by
+   the transmit interrupt, a FIFO's worth at a time.  TXQ_HEAD
+   and TXQ_TAIL run freely; bytes are queued at the head and
+   sent from the tail. */
+#define TXQ_SIZE 16384          /* Must be a power of 2. */
+static uint8_t txq[TXQ_SIZE];
+static size_t txq_head, txq_tail;
+
+/* Threads waiting in serial_putbuf() for the transmit queue to
+   drain.  Each waiter downs TXQ_ROOM once; serial_interrupt()
+   ups it once per waiter after moving bytes into the FIFO. */
+static struct semaphore txq_room;
+static int txq_waiters;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static bool txq_empty (void);
+static uint8_t txq_getc (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -71,7 +92,6 @@ init_poll (void)
   outb (FCR_REG, 0);                    /* Disable FIFO. */
   set_serial (115200);                  /* 115.2 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
   mode = POLL;
 } 
 
@@ -87,9 +107,17 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  sema_init (&txq_room, 0);
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
-  mode = QUEUE;
   old_level = intr_disable ();
+
+  /* Turn on the FIFOs, so that each transmit interrupt can send
+     XMIT_FIFO_SIZE bytes instead of one.  Changing FCR_ENABLE
+     resets the FIFOs, so let the last polled byte finish. */
+  while ((inb (LSR_REG) & LSR_TEMT) == 0)
+    continue;
+  outb (FCR_REG, FCR_ENABLE);
+  mode = QUEUE;
   write_ier ();
   intr_set_level (old_level);
 }
@@ -97,32 +125,67 @@ serial_init_queue (void)
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) 
+{
+  serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port. */
+void
+serial_putbuf (const uint8_t *buffer, size_t n) 
 {
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (n-- > 0)
+        putc_poll (*buffer++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      /* Otherwise, copy into the transmit queue in as few pieces
+         as its wraparound allows and update the interrupt
+         enable register. */
+      while (n > 0)
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          size_t ofs = txq_head % TXQ_SIZE;
+          size_t room = TXQ_SIZE - (txq_head - txq_tail);
+          size_t chunk = n;
+
+          if (room == 0)
+            {
+              if (old_level == INTR_ON && !intr_context ())
+                {
+                  /* The transmit queue is full.  Make sure the
+                     transmit interrupt is on and sleep until it
+                     has drained some of the queue. */
+                  write_ier ();
+                  txq_waiters++;
+                  sema_down (&txq_room);
+                }
+              else
+                {
+                  /* The caller had interrupts off, so we may not
+                     sleep.  Send a FIFO's worth of characters via
+                     polling instead. */
+                  int i;
+                  for (i = 0; i < XMIT_FIFO_SIZE; i++)
+                    putc_poll (txq_getc ());
+                }
+              continue;
+            }
+          if (chunk > room)
+            chunk = room;
+          if (chunk > TXQ_SIZE - ofs)
+            chunk = TXQ_SIZE - ofs;
+          memcpy (txq + ofs, buffer, chunk);
+          txq_head += chunk;
+          buffer += chunk;
+          n -= chunk;
         }
-
-      intq_putc (&txq, byte); 
       write_ier ();
     }
   
@@ -135,8 +198,8 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  while (!txq_empty ())
+    putc_poll (txq_getc ());
   intr_set_level (old_level);
 }
 
@@ -182,7 +245,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (!txq_empty ())
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -205,6 +268,22 @@ putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Returns true if there is nothing left to transmit. */
+static bool
+txq_empty (void) 
+{
+  return txq_head == txq_tail;
+}
+
+/* Removes and returns the oldest byte in the transmit queue,
+   which must not be empty. */
+static uint8_t
+txq_getc (void) 
+{
+  ASSERT (!txq_empty ());
+  return txq[txq_tail++ % TXQ_SIZE];
+}
+
 /* Serial interrupt handler. */
 static void
 serial_interrupt (struct intr_frame *f UNUSED) 
@@ -218,10 +297,19 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* Once the transmit FIFO has emptied, refill it from the
+     transmit queue. */
+  if ((inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      int i;
+      for (i = 0; i < XMIT_FIFO_SIZE && !txq_empty (); i++)
+        outb (THR_REG, txq_getc ());
+    }
+
+  /* Wake any writers that found the transmit queue full. */
+  if (txq_head - txq_tail < TXQ_SIZE)
+    for (; txq_waiters > 0; txq_waiters--)
+      sema_up (&txq_room);
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
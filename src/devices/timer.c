@@ -3,8 +3,11 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include <user/syscall.h>
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/mp.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
   
@@ -24,32 +27,95 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time-stamp counter frequency and reading at calibration,
+   published read-only to user programs.  Initialized by
+   timer_calibrate(). */
+static struct clock_page *clock_page;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
+static void calibrate_tsc (void);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 
-/* 블락되는 타이머들을 모아두는 리스트 */
-static struct list timer_block_list;
-
-/* list elem에서 ublock time을 저장해 놓았던 것을 바탕으로 작은 순서 대로 리스트 정렬을 
-  돕기 위한 보조 함수 */
-static bool 
-timer_set_block_list (const struct list_elem* a_, const struct list_elem* b_, void* aux UNUSED)
+/* 블락되는 타이머들을 모아두는 timing wheel.
+
+   Sleeping threads wait in a two-level hierarchical timing
+   wheel, so that timer_sleep() inserts in O(1) and each timer
+   interrupt only touches the threads it wakes.  wheel0 has one
+   slot per tick for the next WHEEL0_SIZE ticks.  wheel1 has one
+   slot per WHEEL0_SIZE ticks for the WHEEL1_SIZE spans after
+   that; a wheel1 slot is moved down into wheel0 when its span
+   begins.  Later wakeups wait in wheel_overflow, which is
+   re-sorted into the wheels once per wheel1 revolution. */
+#define WHEEL0_BITS 8
+#define WHEEL0_SIZE (1 << WHEEL0_BITS)
+#define WHEEL1_BITS 6
+#define WHEEL1_SIZE (1 << WHEEL1_BITS)
+static struct list wheel0[WHEEL0_SIZE];
+static struct list wheel1[WHEEL1_SIZE];
+static struct list wheel_overflow;
+
+/* First tick whose wheel0 slot has not been processed yet. */
+static int64_t wheel_time;
+
+/* Longest single timer_wakeup() call, in CPU cycles, since the
+   last call to timer_wakeup_worst(). */
+static uint64_t wakeup_worst_cycles;
+
+static void timer_wakeup (void);
+
+/* 8254 input frequency divided by TIMER_FREQ, rounded to
+   nearest: the number of PIT counts in one tick. */
+#define PIT_COUNT ((1193180 + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* If true, the timer stops ticking while the CPU is idle; see
+   timer_idle_enter().  Controlled by kernel command-line option
+   "-tickless". */
+bool timer_tickless;
+
+/* True while the PIT is in one-shot mode.  Its interrupt then
+   arrives ONESHOT_COUNT counts after it was programmed and
+   stands for ONESHOT_TICKS ticks. */
+static bool oneshot;
+static unsigned oneshot_count;
+static int oneshot_ticks;
+
+static void pit_periodic (void);
+static void pit_oneshot (unsigned count);
+
+/* Adds sleeping thread T to the wheel slot for its wakeup
+   time.  A wakeup time that has already passed goes in the next
+   slot to be processed. */
+static void
+wheel_insert (struct thread *t)
 {
+  int64_t expires = t->wakeup_time > wheel_time ? t->wakeup_time : wheel_time;
+  int64_t delta = expires - wheel_time;
+  struct list *slot;
+
+  if (delta < WHEEL0_SIZE)
+    slot = &wheel0[expires % WHEEL0_SIZE];
+  else if (delta < WHEEL0_SIZE * WHEEL1_SIZE)
+    slot = &wheel1[(expires >> WHEEL0_BITS) % WHEEL1_SIZE];
+  else
+    slot = &wheel_overflow;
+  list_push_back (slot, &t->elem);
+}
 
-  const struct thread* a = list_entry(a_, struct thread, elem);
-  const struct thread* b = list_entry(b_, struct thread, elem);
-  
-  if (b->wakeup_time > a->wakeup_time)
-    return true;
-
-  else if (a->wakeup_time == b->wakeup_time)
-    return (a->priority > b->priority);
-
-  else return false;
+/* Re-inserts each thread in SLOT relative to the current wheel
+   time, which moves them toward wheel0. */
+static void
+wheel_cascade (struct list *slot)
+{
+  struct list pending;
 
- }
+  list_init (&pending);
+  while (!list_empty (slot))
+    list_push_back (&pending, list_pop_front (slot));
+  while (!list_empty (&pending))
+    wheel_insert (list_entry (list_pop_front (&pending), struct thread, elem));
+}
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -57,18 +123,17 @@ timer_set_block_list (const struct list_elem* a_, const struct list_elem* b_, vo
 void
 timer_init (void) 
 {
-  /* 8254 input frequency divided by TIMER_FREQ, rounded to
-     nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-  outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-  outb (0x40, count & 0xff);
-  outb (0x40, count >> 8);
+  int i;
 
+  pit_periodic ();
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 
-  /* 타이머 블락 리스트 초기화 필요 */
-  list_init (&timer_block_list);
+  /* 타이머 wheel 초기화 필요 */
+  for (i = 0; i < WHEEL0_SIZE; i++)
+    list_init (&wheel0[i]);
+  for (i = 0; i < WHEEL1_SIZE; i++)
+    list_init (&wheel1[i]);
+  list_init (&wheel_overflow);
 
 }
 
@@ -98,6 +163,61 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  calibrate_tsc ();
+}
+
+/* Measures the time-stamp counter frequency against the PIT over
+   TIMER_FREQ / 10 ticks, from one tick boundary to another. */
+static void
+calibrate_tsc (void)
+{
+  int64_t start;
+  uint64_t tsc_start;
+
+  clock_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  start++;
+  tsc_start = timer_cycles ();
+  while (timer_elapsed (start) < TIMER_FREQ / 10)
+    continue;
+
+  clock_page->tsc_hz = (timer_cycles () - tsc_start) * 10;
+  clock_page->tsc_boot = tsc_start;
+  printf ("Timer: %'"PRIu64" TSC cycles/s.\n", (uint64_t) clock_page->tsc_hz);
+}
+
+/* Returns the read-only page describing the clock, for mapping
+   into user processes. */
+void *
+timer_clock_page (void)
+{
+  return clock_page;
+}
+
+/* Converts CYCLES time-stamp counter cycles to nanoseconds.
+   Returns 0 before timer_calibrate(). */
+uint64_t
+timer_cycles_to_ns (uint64_t cycles)
+{
+  uint64_t hz = clock_page != NULL ? clock_page->tsc_hz : 0;
+
+  if (hz == 0)
+    return 0;
+  return cycles / hz * 1000000000 + cycles % hz * 1000000000 / hz;
+}
+
+/* Returns nanoseconds since timer_calibrate(), from the
+   time-stamp counter.  Returns 0 before then. */
+uint64_t
+timer_ns (void)
+{
+  if (clock_page == NULL)
+    return 0;
+  return timer_cycles_to_ns (timer_cycles () - clock_page->tsc_boot);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -125,45 +245,71 @@ void
 timer_sleep (int64_t ticks) 
 {
   int64_t start = timer_ticks ();
-  /* interrupt로 에러가 남. 인터럽트 방지 */
-  enum intr_level old_level = intr_disable ();
-  /* busy waiting을 막기 위해 yield 제거 */
-  //ASSERT (intr_get_level () == INTR_ON);
-  //while (timer_elapsed ㅇ(start) < ticks) 
-  //  thread_yield ();
-  struct thread *curr_thread = thread_current ();
+  enum intr_level old_level;
+  struct thread *curr_thread;
 
+  if (ticks <= 0)
+    return;
+
+  /* interrupt로 에러가 남. 인터럽트 방지 */
+  old_level = intr_disable ();
+  curr_thread = thread_current ();
 
   /* thread의 wakeup time 저장 */
   curr_thread->wakeup_time = start + ticks;
 
-  /* timer block list에 wake up할 순서대로 저장해야한다 */
-  list_insert_ordered(&timer_block_list, &curr_thread->elem, timer_set_block_list, NULL);
+  /* wakeup time에 해당하는 wheel slot에 넣는다 */
+  wheel_insert (curr_thread);
 
   /* 블락 */
   thread_block();
 
   /* interrupt 방지 */ 
   intr_set_level(old_level);
- 
-
 }
 
-
-void
+/* Wakes the threads in every wheel0 slot up to the current
+   tick, first moving down any wheel1 slot or overflow threads
+   whose span is starting. */
+static void
 timer_wakeup (void)
 {
-  while (!list_empty(&timer_block_list))
+  uint64_t start = timer_cycles ();
+  uint64_t elapsed;
+
+  while (wheel_time <= ticks)
   {
-    struct thread* next_thread = list_entry(list_front(&timer_block_list), struct thread, elem);
-    if (ticks < next_thread->wakeup_time) 
-      break;
+    struct list *slot = &wheel0[wheel_time % WHEEL0_SIZE];
 
-    list_pop_front(&timer_block_list);
-    thread_unblock(next_thread);
+    if (wheel_time % WHEEL0_SIZE == 0)
+    {
+      if (wheel_time % (WHEEL0_SIZE * WHEEL1_SIZE) == 0)
+        wheel_cascade (&wheel_overflow);
+      wheel_cascade (&wheel1[(wheel_time >> WHEEL0_BITS) % WHEEL1_SIZE]);
+    }
 
+    /* slot의 thread들은 모두 이번 tick에 깨어나야 한다 */
+    while (!list_empty (slot))
+      thread_unblock (list_entry (list_pop_front (slot), struct thread, elem));
+    wheel_time++;
   }
 
+  elapsed = timer_cycles () - start;
+  if (elapsed > wakeup_worst_cycles)
+    wakeup_worst_cycles = elapsed;
+}
+
+/* Returns the longest time, in CPU cycles, that the timer
+   interrupt has spent waking sleeping threads since the last
+   call, and starts a new measurement. */
+uint64_t
+timer_wakeup_worst (void)
+{
+  enum intr_level old_level = intr_disable ();
+  uint64_t worst = wakeup_worst_cycles;
+  wakeup_worst_cycles = 0;
+  intr_set_level (old_level);
+  return worst;
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -192,6 +338,8 @@ void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  printf ("Timer: longest wakeup pass %"PRIu64" cycles\n",
+          wakeup_worst_cycles);
 }
 
 
@@ -200,12 +348,137 @@ timer_print_stats (void)
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-  /* thread wakeup 시켜야 한다 */
-  timer_wakeup ();
-  thread_tick ();
+  int tick_cnt = 1;
+
+  /* A one-shot interrupt ends a tickless stretch and stands for
+     every tick in it.  None of them had a sleeper to wake, so
+     replaying them one by one does only the bookkeeping. */
+  if (oneshot)
+    {
+      tick_cnt = oneshot_ticks;
+      oneshot = false;
+      pit_periodic ();
+    }
+
+  while (tick_cnt-- > 0)
+    {
+      ticks++;
+      /* thread wakeup 시켜야 한다 */
+      timer_wakeup ();
+      thread_tick ();
+    }
+}
+
+/* Sets up PIT counter 0 to interrupt every PIT_COUNT counts,
+   that is, TIMER_FREQ times per second. */
+static void
+pit_periodic (void)
+{
+  outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+  outb (0x40, PIT_COUNT & 0xff);
+  outb (0x40, PIT_COUNT >> 8);
+}
+
+/* Sets up PIT counter 0 to interrupt once, COUNT counts from
+   now. */
+static void
+pit_oneshot (unsigned count)
+{
+  ASSERT (count > 0 && count <= 0xffff);
+
+  outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+  outb (0x40, count & 0xff);
+  outb (0x40, count >> 8);
+}
+
+/* Returns the smaller of A and B. */
+static int64_t
+min64 (int64_t a, int64_t b)
+{
+  return a < b ? a : b;
 }
 
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  In tickless mode, stops the periodic tick and
+   instead programs the PIT to interrupt once at the next tick
+   that has work: a sleeper to wake, a wheel1 slot to move down,
+   or an MLFQS once-per-second update.  A 16-bit PIT count
+   reaches only a few ticks ahead, so stretches are short.
+
+   Only the BSP's idle thread calls this, and only while no AP
+   runs: an AP could add a sleeper due before the programmed
+   interrupt. */
+void
+timer_idle_enter (void)
+{
+  unsigned remaining;
+  int64_t last, t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot || cpu_started_cnt > 1)
+    return;
+
+  /* Counts left in the current tick. */
+  outb (0x43, 0x00);    /* Latch counter 0. */
+  remaining = inb (0x40);
+  remaining |= inb (0x40) << 8;
+
+  /* Find the last tick we may sleep through to. */
+  last = ticks + (0xffff - remaining) / PIT_COUNT + 1;
+  last = min64 (last, (ticks / TIMER_FREQ + 1) * TIMER_FREQ);
+  last = min64 (last, (ticks / WHEEL0_SIZE + 1) * WHEEL0_SIZE);
+  for (t = wheel_time; t < last; t++)
+    if (!list_empty (&wheel0[t % WHEEL0_SIZE]))
+      break;
+  if (t - ticks < 2)
+    return;
+
+  oneshot_ticks = t - ticks;
+  oneshot_count = remaining + (oneshot_ticks - 1) * PIT_COUNT;
+  pit_oneshot (oneshot_count);
+  oneshot = true;
+}
+
+/* Called with interrupts off when the idle thread is about to
+   be switched out.  If an interrupt other than the timer's
+   ended a tickless stretch early, accounts for the whole ticks
+   that passed and programs a one-shot interrupt at the next
+   tick boundary, where the timer interrupt resumes the periodic
+   tick. */
+void
+timer_idle_exit (void)
+{
+  unsigned status, count;
+  int whole;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!oneshot)
+    return;
+
+  outb (0x43, 0xc2);    /* Read back status and count of counter 0. */
+  status = inb (0x40);
+  count = inb (0x40);
+  count |= inb (0x40) << 8;
+
+  /* If OUT is high the interrupt is already pending; it will do
+     the accounting. */
+  if (status & 0x80)
+    return;
+
+  /* Tick boundaries fall where COUNT is a multiple of PIT_COUNT.
+     Those at or above COUNT have passed. */
+  whole = oneshot_ticks - DIV_ROUND_UP (count, PIT_COUNT);
+  ticks += whole;
+  thread_tick_idle (whole);
+
+  oneshot_ticks = 1;
+  oneshot_count = count % PIT_COUNT != 0 ? count % PIT_COUNT : PIT_COUNT;
+  pit_oneshot (oneshot_count);
+}
+
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
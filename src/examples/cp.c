@@ -1,14 +1,22 @@
-/* cat.c
+/* cp.c
 
 Copies one file to another. */
 
 #include <stdio.h>
 #include <syscall.h>
 
+/* Bytes to copy per copy_range() call. */
+#define CHUNK_SIZE (64 * 1024)
+
+/* Copies at least this large report their throughput. */
+#define REPORT_THRESHOLD (64 * 1024)
+
 int
 main (int argc, char *argv[]) 
 {
   int in_fd, out_fd;
+  int total = 0;
+  unsigned long long start, ns;
 
   if (argc != 3) 
     {
@@ -37,19 +45,27 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
+  /* Copy data inside the kernel, a chunk at a time so that other
+     processes get a turn at the file system in between. */
+  start = clock_ns ();
   for (;;) 
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
+      int bytes_copied = copy_range (in_fd, out_fd, CHUNK_SIZE);
+      if (bytes_copied < 0) 
         {
-          printf ("%s: write failed\n", argv[2]);
+          printf ("%s: copy failed\n", argv[2]);
           return EXIT_FAILURE;
         }
+      if (bytes_copied == 0)
+        break;
+      total += bytes_copied;
     }
+  ns = clock_ns () - start;
+
+  /* Report throughput for large copies. */
+  if (total >= REPORT_THRESHOLD && ns > 0)
+    printf ("cp: %d bytes in %llu us (%llu kB/s)\n",
+            total, ns / 1000, (unsigned long long) total * 1000000 / ns);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,52 @@
+/* faultbench.c
+
+   Measures page fault throughput.  Touches every page of a
+   buffer larger than a default user pool, first in order and
+   then in a scattered order, so that once memory fills up each
+   touch must evict a frame.
+
+   Usage: faultbench [PASSES] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#define PAGE_SIZE 4096
+
+/* Buffer size, in pages. */
+#define PAGE_CNT 1024
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Writes to one byte of each page of BUF, visiting page
+   (I * STRIDE) % PAGE_CNT on step I, and prints the time taken. */
+static void
+touch (const char *name, int stride, int pass)
+{
+  unsigned long long start = clock_ns ();
+  unsigned long long ns;
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[(size_t) (i * stride % PAGE_CNT) * PAGE_SIZE] = pass;
+  ns = clock_ns () - start;
+
+  printf ("%s pass %d: %d pages in %llu us, %llu ns/page\n",
+          name, pass, PAGE_CNT, ns / 1000, ns / PAGE_CNT);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int passes = argc > 1 ? atoi (argv[1]) : 3;
+  int pass;
+
+  for (pass = 1; pass <= passes; pass++)
+    touch ("sequential", 1, pass);
+
+  /* 389 is prime, so this visits every page once. */
+  for (pass = 1; pass <= passes; pass++)
+    touch ("scattered", 389, pass);
+
+  return EXIT_SUCCESS;
+}
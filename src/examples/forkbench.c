@@ -0,0 +1,77 @@
+/* forkbench.c
+
+   Measures fork() with copy-on-write.  Dirties a buffer, then
+   forks a child that either exits at once or writes to some of
+   the buffer's pages, and reports how long fork() and each
+   child's copy-on-write faults took.  The parent checks that
+   the child's writes did not reach its own copy.
+
+   Usage: forkbench [FORKS] [WRITE-PAGES] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#define PAGE_SIZE 4096
+
+/* Buffer size, in pages. */
+#define PAGE_CNT 256
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* In the child: writes to the first WRITES pages of BUF, prints
+   the time taken, and exits. */
+static void
+child (int writes)
+{
+  unsigned long long start = clock_ns ();
+  unsigned long long ns;
+  int i;
+
+  for (i = 0; i < writes; i++)
+    buf[(size_t) i * PAGE_SIZE] = 'c';
+  ns = clock_ns () - start;
+  if (writes > 0)
+    printf ("child: %d copy-on-write faults in %llu us, %llu ns/page\n",
+            writes, ns / 1000, ns / writes);
+  exit (EXIT_SUCCESS);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int forks = argc > 1 ? atoi (argv[1]) : 8;
+  int writes = argc > 2 ? atoi (argv[2]) : PAGE_CNT / 4;
+  int i;
+
+  if (writes > PAGE_CNT)
+    writes = PAGE_CNT;
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[(size_t) i * PAGE_SIZE] = 'p';
+
+  for (i = 0; i < forks; i++)
+    {
+      unsigned long long start = clock_ns ();
+      pid_t pid = fork ();
+      unsigned long long ns;
+
+      if (pid == 0)
+        child (i % 2 ? writes : 0);
+      ns = clock_ns () - start;
+      if (pid == PID_ERROR)
+        {
+          printf ("fork failed\n");
+          return EXIT_FAILURE;
+        }
+      wait (pid);
+      printf ("fork %d: %llu us\n", i, ns / 1000);
+    }
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[(size_t) i * PAGE_SIZE] != 'p')
+      {
+        printf ("page %d changed by child\n", i);
+        return EXIT_FAILURE;
+      }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+/* logbench.c
+
+   Measures console logging throughput.  Writes the same number
+   of bytes to the console as short log lines and as large
+   blocks, then reports the cost of each. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Bytes written by each phase. */
+#define TOTAL (64 * 1024)
+
+/* Length of one log line, including the new-line. */
+#define LINE_SIZE 64
+
+/* Bytes per write in the block phase. */
+#define BLOCK_SIZE 4096
+
+/* Writes TOTAL bytes from BUFFER to the console, SIZE bytes
+   per write() call, and returns the elapsed nanoseconds. */
+static unsigned long long
+log_phase (const char *buffer, int size)
+{
+  unsigned long long start = clock_ns ();
+  int written;
+
+  for (written = 0; written < TOTAL; written += size)
+    write (STDOUT_FILENO, buffer, size);
+  return clock_ns () - start;
+}
+
+int
+main (void) 
+{
+  static char block[BLOCK_SIZE];
+  unsigned long long lines, blocks;
+  int i;
+
+  for (i = 0; i < BLOCK_SIZE; i++)
+    block[i] = i % LINE_SIZE == LINE_SIZE - 1 ? '\n' : 'a' + i % 26;
+
+  lines = log_phase (block, LINE_SIZE);
+  blocks = log_phase (block, BLOCK_SIZE);
+
+  printf ("logbench: %d-byte lines: %d bytes in %llu us (%llu kB/s)\n",
+          LINE_SIZE, TOTAL, lines / 1000, TOTAL * 1000000ULL / lines);
+  printf ("logbench: %d-byte blocks: %d bytes in %llu us (%llu kB/s)\n",
+          BLOCK_SIZE, TOTAL, blocks / 1000, TOTAL * 1000000ULL / blocks);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+/* ringbench.c
+
+   Compares the cost of small writes issued one trap at a time
+   with the same writes submitted in batches through the system
+   call ring. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Writes issued by each phase. */
+#define OPS 1024
+
+/* Bytes per write. */
+#define WRITE_SIZE 16
+
+static struct ring_sq sq __attribute__ ((aligned (4096)));
+static struct ring_cq cq __attribute__ ((aligned (4096)));
+
+/* Creates and opens a fresh file named NAME. */
+static int
+open_fresh (const char *name)
+{
+  int fd;
+
+  remove (name);
+  if (!create (name, 0))
+    {
+      printf ("%s: create failed\n", name);
+      exit (EXIT_FAILURE);
+    }
+  fd = open (name);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", name);
+      exit (EXIT_FAILURE);
+    }
+  return fd;
+}
+
+/* Prints the result of one phase. */
+static void
+report (const char *phase, unsigned long long ns)
+{
+  printf ("%s: %d writes in %llu us, %llu ns/write\n",
+          phase, OPS, ns / 1000, ns / OPS);
+}
+
+int
+main (void) 
+{
+  static char data[WRITE_SIZE];
+  unsigned long long start;
+  int fd, i;
+
+  memset (data, 'x', sizeof data);
+
+  /* One trap per write. */
+  fd = open_fresh ("ringbench.trap");
+  start = clock_ns ();
+  for (i = 0; i < OPS; i++)
+    if (write (fd, data, sizeof data) != sizeof data)
+      {
+        printf ("write failed\n");
+        return EXIT_FAILURE;
+      }
+  report ("trap", clock_ns () - start);
+  close (fd);
+
+  /* The same writes, submitted a ring at a time. */
+  if (!ring_setup (&sq, &cq))
+    {
+      printf ("ring_setup failed\n");
+      return EXIT_FAILURE;
+    }
+  fd = open_fresh ("ringbench.ring");
+  start = clock_ns ();
+  for (i = 0; i < OPS; )
+    {
+      int batch = 0;
+
+      while (batch < RING_ENTRIES && i + batch < OPS)
+        {
+          struct ring_sqe *sqe = &sq.entries[sq.tail % RING_ENTRIES];
+          sqe->opcode = RING_OP_WRITE;
+          sqe->fd = fd;
+          sqe->buffer = data;
+          sqe->length = sizeof data;
+          sqe->user_data = i + batch;
+          sq.tail++;
+          batch++;
+        }
+      if (ring_enter (batch) != batch)
+        {
+          printf ("ring_enter failed\n");
+          return EXIT_FAILURE;
+        }
+      for (; cq.head != cq.tail; cq.head++)
+        if (cq.entries[cq.head % RING_ENTRIES].result != sizeof data)
+          {
+            printf ("ring write %u failed\n",
+                    cq.entries[cq.head % RING_ENTRIES].user_data);
+            return EXIT_FAILURE;
+          }
+      i += batch;
+    }
+  report ("ring", clock_ns () - start);
+  close (fd);
+
+  remove ("ringbench.trap");
+  remove ("ringbench.ring");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+/* sysstat.c
+
+   Prints the kernel's per-system-call counts and latencies.
+   With arguments, prints only the named system calls. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+/* Returns the smallest latency, in cycles, that bounds the
+   fastest PERCENT percent of the calls in S. */
+static unsigned long long
+percentile (const struct sysstat *s, unsigned percent)
+{
+  unsigned long long total = 0, seen = 0;
+  int i;
+
+  for (i = 0; i < SYSSTAT_BUCKETS; i++)
+    total += s->hist[i];
+  for (i = 0; i < SYSSTAT_BUCKETS - 1; i++)
+    {
+      seen += s->hist[i];
+      if (seen * 100 >= total * percent)
+        break;
+    }
+  return (2ULL << i) - 1;
+}
+
+/* Returns true if NAME is one of the ARGC - 1 names in ARGV,
+   or if there are no names at all. */
+static bool
+selected (const char *name, int argc, char *argv[])
+{
+  int i;
+
+  if (argc < 2)
+    return true;
+  for (i = 1; i < argc; i++)
+    if (!strcmp (name, argv[i]))
+      return true;
+  return false;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int number;
+
+  printf ("%-12s %10s %12s %12s %12s\n",
+          "syscall", "calls", "avg cycles", "p50 <", "p99 <");
+  for (number = 0; number < SYS_CNT; number++)
+    {
+      struct sysstat s;
+
+      if (!sysstat (number, &s) || s.count == 0
+          || !selected (s.name, argc, argv))
+        continue;
+      printf ("%-12s %10llu %12llu %12llu %12llu\n",
+              s.name, s.count, s.cycles / s.count,
+              percentile (&s, 50), percentile (&s, 99));
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+/* thrash.c
+
+   Runs several copies of faultbench at once, so that together
+   they need far more memory than the user pool holds, and
+   reports how long they took.
+
+   Usage: thrash [PROCESSES] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Most processes to run. */
+#define MAX_PROCS 8
+
+int
+main (int argc, char *argv[])
+{
+  pid_t pids[MAX_PROCS];
+  int procs = argc > 1 ? atoi (argv[1]) : 4;
+  unsigned long long start, ns;
+  int failures = 0;
+  int i;
+
+  if (procs < 1 || procs > MAX_PROCS)
+    {
+      printf ("thrash: process count must be between 1 and %d\n", MAX_PROCS);
+      return EXIT_FAILURE;
+    }
+
+  start = clock_ns ();
+  for (i = 0; i < procs; i++)
+    {
+      pids[i] = exec ("faultbench 1");
+      if (pids[i] == PID_ERROR)
+        {
+          printf ("thrash: exec failed\n");
+          procs = i;
+          failures++;
+          break;
+        }
+    }
+  for (i = 0; i < procs; i++)
+    if (wait (pids[i]) != EXIT_SUCCESS)
+      failures++;
+  ns = clock_ns () - start;
+
+  printf ("thrash: %d processes in %llu us, %d failed\n",
+          procs, ns / 1000, failures);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
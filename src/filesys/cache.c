@@ -31,7 +31,7 @@ static bool cache_full(void);
 static void cache_insert(struct cache* cache);
 static void cache_delete(struct cache* cache);
 static void cache_evict(void);
-static struct cache * cache_create(disk_sector_t sector_idx);
+static struct cache * cache_create(disk_sector_t sector_idx, bool fill);
 static struct cache * cache_find(disk_sector_t sector_idx);
 static struct cache * cache_get(disk_sector_t sector_idx);
 
@@ -77,6 +77,28 @@ cache_write(disk_sector_t sector_idx, uint8_t* buffer, int sector_ofs, int chunk
 	cache_release();
 }
 
+/* Copies CHUNK_SIZE bytes from sector SRC_IDX at SRC_OFS to
+   sector DST_IDX at DST_OFS without going through a caller
+   buffer.  A source sector that is already cached is not read
+   again, and a destination sector that is overwritten in full is
+   not read from disk at all. */
+void
+cache_copy(disk_sector_t dst_idx, int dst_ofs, disk_sector_t src_idx, int src_ofs, int chunk_size)
+{
+	struct cache *src, *dst;
+	cache_acquire();
+	src = cache_get(src_idx);
+	src->pinned = true;
+	dst = cache_find(dst_idx);
+	if(!dst) dst = cache_create(dst_idx, chunk_size < DISK_SECTOR_SIZE);
+	memmove(dst->buffer + dst_ofs, src->buffer + src_ofs, chunk_size);
+	src->pinned = false;
+	src->accessed = true;
+	dst->accessed = true;
+	dst->dirty = true;
+	cache_release();
+}
+
 void
 cache_clear(void)
 {
@@ -131,7 +153,7 @@ cache_evict(void)
 	while(true)
 	{
 		cache = list_entry(e, struct cache, elem);
-		if(cache->accessed) cache->accessed = false;
+		if(cache->accessed || cache->pinned) cache->accessed = false;
 		else
 		{
 			list_remove(e);
@@ -143,8 +165,11 @@ cache_evict(void)
 	}
 }
 
+/* Caches sector SECTOR_IDX, reading its contents from disk if
+   FILL is true.  Callers that are about to overwrite the whole
+   sector pass false to skip the read. */
 static struct cache *
-cache_create(disk_sector_t sector_idx)
+cache_create(disk_sector_t sector_idx, bool fill)
 {
 #ifdef DEBUG
 	printf("cache_create(): 진입\n");
@@ -154,9 +179,10 @@ cache_create(disk_sector_t sector_idx)
 	cache = malloc(sizeof(struct cache));
 	cache->sector_idx = sector_idx;
 	cache->buffer = malloc(DISK_SECTOR_SIZE);
-	disk_read(filesys_disk, sector_idx, cache->buffer);
+	if(fill) disk_read(filesys_disk, sector_idx, cache->buffer);
 	cache->accessed = false;
 	cache->dirty = false;
+	cache->pinned = false;
 	cache_insert(cache);
 	return cache;
 }
@@ -186,7 +212,7 @@ cache_get(disk_sector_t sector_idx)
 #endif
 	struct cache *cache;
 	cache = cache_find(sector_idx);
-	if(!cache) cache = cache_create(sector_idx);
+	if(!cache) cache = cache_create(sector_idx, true);
 	return cache;
 }
 
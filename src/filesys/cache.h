@@ -15,6 +15,7 @@ struct cache
 	disk_sector_t sector_idx;
 	bool dirty;
 	bool accessed;
+	bool pinned;	/* Must not be evicted (see cache_copy()). */
 	uint8_t *buffer;
 };
 
@@ -27,6 +28,7 @@ struct read_ahead_entry
 void cache_init(void);
 void cache_read(disk_sector_t sector_idx, uint8_t* buffer, int sector_ofs, int chunk_size);
 void cache_write(disk_sector_t sector_idx, uint8_t* buffer, int sector_ofs, int chunk_size);
+void cache_copy(disk_sector_t dst_idx, int dst_ofs, disk_sector_t src_idx, int src_ofs, int chunk_size);
 void cache_clear(void);
 void cache_read_ahead(disk_sector_t sector_idx);
 
@@ -554,6 +554,24 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
   return bytes_read;
 }
 
+/* Grows INODE to LENGTH bytes and writes the new block layout
+   back to its on-disk inode. */
+static void
+inode_extend (struct inode *inode, off_t length)
+{
+  inode_allocate(inode, length);
+  /* disk inode 를 꺼내 와서 */
+  struct inode_disk *disk_inode = (struct inode_disk *) malloc(DISK_SECTOR_SIZE);
+  cache_read(inode_get_inumber(inode), disk_inode, 0, DISK_SECTOR_SIZE);
+  disk_inode->length = inode->length;
+  disk_inode->block_count = inode->block_count;
+  disk_inode->indirect_count = inode->indirect_count;
+  disk_inode->dindirect_count = inode->dindirect_count;
+  memcpy(disk_inode->blocks, inode->blocks, 14 * sizeof(disk_sector_t));
+  cache_write(inode_get_inumber(inode), disk_inode, 0, DISK_SECTOR_SIZE);
+  free(disk_inode);
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
    Returns the number of bytes actually written, which may be
    less than SIZE if end of file is reached or an error occurs.
@@ -573,19 +591,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     return 0;
 
   if (offset + size > inode->length)
-  {
-    inode_allocate(inode, offset + size);
-    /* disk inode 를 꺼내 와서 */
-    struct inode_disk *disk_inode = (struct inode_disk *) malloc(DISK_SECTOR_SIZE);
-    cache_read(inode_get_inumber(inode), disk_inode, 0, DISK_SECTOR_SIZE);
-    disk_inode->length = inode->length;
-    disk_inode->block_count = inode->block_count;
-    disk_inode->indirect_count = inode->indirect_count;
-    disk_inode->dindirect_count = inode->dindirect_count;
-    memcpy(disk_inode->blocks, inode->blocks, 14 * sizeof(disk_sector_t));
-    cache_write(inode_get_inumber(inode), disk_inode, 0, DISK_SECTOR_SIZE);
-    free(disk_inode);
-  }
+    inode_extend(inode, offset + size);
 
   while (size > 0) 
     {
@@ -625,6 +631,64 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Copies SIZE bytes from SRC, starting at SRC_OFS, into DST,
+   starting at DST_OFS, growing DST if necessary.  The data moves
+   between buffer cache entries directly, one sector-sized chunk
+   at a time, and never passes through a caller's buffer.
+   Returns the number of bytes actually copied, which may be less
+   than SIZE if end of SRC is reached or DST denies writes. */
+off_t
+inode_copy_at (struct inode *dst, off_t dst_ofs,
+               struct inode *src, off_t src_ofs, off_t size)
+{
+  off_t src_length = inode_length (src);
+  off_t bytes_copied = 0;
+
+  if (dst->deny_write_cnt)
+    return 0;
+  /* Compare against what is left rather than adding, so that a huge
+     SIZE cannot overflow off_t and skip the clamp. */
+  if (size <= 0 || src_ofs < 0 || src_ofs >= src_length || dst_ofs < 0)
+    return 0;
+  if (size > src_length - src_ofs)
+    size = src_length - src_ofs;
+  if (size > INT32_MAX - dst_ofs)
+    size = INT32_MAX - dst_ofs;
+  if (size <= 0)
+    return 0;
+
+  if (size > dst->length - dst_ofs)
+    inode_extend(dst, dst_ofs + size);
+
+  while (size > 0)
+    {
+      disk_sector_t src_idx = byte_to_sector (src, src_ofs);
+      disk_sector_t dst_idx = byte_to_sector (dst, dst_ofs);
+      /* Past the end of either inode, e.g. DST could not grow. */
+      if (src_idx == (disk_sector_t) -1 || dst_idx == (disk_sector_t) -1)
+        break;
+      int src_sector_ofs = src_ofs % DISK_SECTOR_SIZE;
+      int dst_sector_ofs = dst_ofs % DISK_SECTOR_SIZE;
+
+      /* Bytes left in each sector, lesser of the two and SIZE. */
+      int src_left = DISK_SECTOR_SIZE - src_sector_ofs;
+      int dst_left = DISK_SECTOR_SIZE - dst_sector_ofs;
+      int chunk_size = src_left < dst_left ? src_left : dst_left;
+      if (size < chunk_size)
+        chunk_size = size;
+
+      cache_copy(dst_idx, dst_sector_ofs, src_idx, src_sector_ofs, chunk_size);
+      if(src_idx + 1 < disk_size(filesys_disk)) cache_read_ahead(src_idx + 1);
+
+      /* Advance. */
+      size -= chunk_size;
+      src_ofs += chunk_size;
+      dst_ofs += chunk_size;
+      bytes_copied += chunk_size;
+    }
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
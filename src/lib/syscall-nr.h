@@ -28,7 +28,17 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_COPY_RANGE,             /* Copy bytes between two files in the kernel. */
+    SYS_RING_SETUP,             /* Register a submission/completion ring. */
+    SYS_RING_ENTER,             /* Process queued ring submissions. */
+    SYS_SYSSTAT,                /* Read one system call's statistics. */
+    SYS_CLOCK,                  /* Read the monotonic clock. */
+    SYS_FORK,                   /* Duplicate the current process. */
+
+    SYS_CNT                     /* Number of system calls. */
   };
 
 #endif /* lib/syscall-nr.h */
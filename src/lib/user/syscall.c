@@ -182,3 +182,52 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+copy_range (int in_fd, int out_fd, unsigned length)
+{
+  return syscall3 (SYS_COPY_RANGE, in_fd, out_fd, length);
+}
+
+bool
+ring_setup (struct ring_sq *sq, struct ring_cq *cq)
+{
+  return syscall2 (SYS_RING_SETUP, sq, cq);
+}
+
+int
+ring_enter (unsigned to_submit)
+{
+  return syscall1 (SYS_RING_ENTER, to_submit);
+}
+
+bool
+sysstat (int number, struct sysstat *stat)
+{
+  return syscall2 (SYS_SYSSTAT, number, stat);
+}
+
+int
+clock_gettime (struct timespec *ts)
+{
+  return syscall1 (SYS_CLOCK, ts);
+}
+
+pid_t
+fork (void)
+{
+  return syscall0 (SYS_FORK);
+}
+
+/* Returns nanoseconds since boot, read through the clock page
+   without entering the kernel. */
+unsigned long long
+clock_ns (void)
+{
+  unsigned long long hz = CLOCK_PAGE->tsc_hz;
+  unsigned long long tsc;
+
+  asm volatile ("rdtsc" : "=A" (tsc));
+  tsc -= CLOCK_PAGE->tsc_boot;
+  return tsc / hz * 1000000000ULL + tsc % hz * 1000000000ULL / hz;
+}
@@ -15,6 +15,87 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* Batched system call ring.  The process owns one page holding a
+   submission queue and one holding a completion queue.  It fills
+   in submission entries, advances the submission tail, and calls
+   ring_enter() once to have the kernel process all of them.  The
+   kernel consumes entries from the submission head and appends one
+   completion per entry at the completion tail; the process
+   consumes completions from the completion head.  Indexes only
+   ever increase and are reduced modulo RING_ENTRIES. */
+#define RING_ENTRIES 128
+
+/* Operations for ring_sqe's `opcode'. */
+enum ring_op
+  {
+    RING_OP_READ,               /* read (fd, buffer, length). */
+    RING_OP_WRITE,              /* write (fd, buffer, length). */
+    RING_OP_OPEN,               /* open (buffer). */
+    RING_OP_CLOSE               /* close (fd). */
+  };
+
+/* Submission queue entry. */
+struct ring_sqe
+  {
+    int opcode;                 /* One of enum ring_op. */
+    int fd;                     /* File descriptor. */
+    void *buffer;               /* Data buffer or file name. */
+    unsigned length;            /* Bytes to read or write. */
+    unsigned user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry. */
+struct ring_cqe
+  {
+    unsigned user_data;         /* From the submission. */
+    int result;                 /* Return value, -1 on error. */
+  };
+
+/* Submission queue page. */
+struct ring_sq
+  {
+    unsigned head;              /* Next entry the kernel consumes. */
+    unsigned tail;              /* Next entry the process fills. */
+    struct ring_sqe entries[RING_ENTRIES];
+  };
+
+/* Completion queue page. */
+struct ring_cq
+  {
+    unsigned head;              /* Next entry the process consumes. */
+    unsigned tail;              /* Next entry the kernel fills. */
+    struct ring_cqe entries[RING_ENTRIES];
+  };
+
+/* Statistics for one system call, as returned by sysstat(). */
+#define SYSSTAT_BUCKETS 32
+struct sysstat
+  {
+    char name[16];              /* System call name. */
+    unsigned long long count;   /* Number of calls. */
+    unsigned long long cycles;  /* Total CPU cycles spent in calls. */
+    unsigned hist[SYSSTAT_BUCKETS]; /* hist[i] counts calls that took
+                                   2**i to 2**(i+1) - 1 cycles. */
+  };
+
+/* Monotonic time since boot, as returned by clock_gettime(). */
+struct timespec
+  {
+    long tv_sec;                /* Seconds. */
+    long tv_nsec;               /* Nanoseconds, 0 to 999,999,999. */
+  };
+
+/* The kernel maps this read-only page into every process at
+   CLOCK_PAGE, so that clock_ns() can read the time without a
+   system call.  Nanoseconds since boot are
+   (rdtsc - tsc_boot) * 1e9 / tsc_hz. */
+struct clock_page
+  {
+    unsigned long long tsc_hz;  /* Time-stamp counter frequency. */
+    unsigned long long tsc_boot; /* Time-stamp counter at boot. */
+  };
+#define CLOCK_PAGE ((const struct clock_page *) 0x08047000)
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -45,4 +126,13 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+int copy_range (int in_fd, int out_fd, unsigned length);
+bool ring_setup (struct ring_sq *, struct ring_cq *);
+int ring_enter (unsigned to_submit);
+bool sysstat (int number, struct sysstat *);
+int clock_gettime (struct timespec *);
+unsigned long long clock_ns (void);
+pid_t fork (void);
+
 #endif /* lib/user/syscall.h */
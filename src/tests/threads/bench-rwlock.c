@@ -0,0 +1,110 @@
+/* Compares the throughput of a readers-writer lock against a
+   plain lock on a read-mostly workload.  THREAD_CNT threads each
+   perform OP_CNT operations on a shared table, one in every
+   WRITE_RATIO of them a write.  Each operation yields once while
+   holding the lock, standing in for a lookup that sleeps, so
+   that readers actually overlap.  Reports operations per
+   millisecond for each kind of lock.
+
+   This is a benchmark, not a graded test. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define THREAD_CNT 16
+#define OP_CNT 500
+#define WRITE_RATIO 16
+#define TABLE_SIZE 64
+
+static struct lock table_lock;
+static struct rwlock table_rwlock;
+static int table[TABLE_SIZE];
+
+struct worker
+  {
+    int id;                     /* Worker ID. */
+    bool use_rwlock;            /* Use table_rwlock or table_lock? */
+    struct semaphore *done;     /* Upped when the worker finishes. */
+  };
+
+static thread_func worker_thread;
+static void run (const char *name, bool use_rwlock);
+
+void
+test_bench_rwlock (void) 
+{
+  /* This benchmark does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&table_lock);
+  rw_init (&table_rwlock);
+  run ("lock", false);
+  run ("rwlock", true);
+}
+
+static void
+run (const char *name, bool use_rwlock) 
+{
+  static struct worker workers[THREAD_CNT];
+  struct semaphore done;
+  uint64_t begin, elapsed_us;
+  int cnt, i;
+
+  sema_init (&done, 0);
+  begin = timer_ns ();
+  for (cnt = 0; cnt < THREAD_CNT; cnt++)
+    {
+      workers[cnt].id = cnt;
+      workers[cnt].use_rwlock = use_rwlock;
+      workers[cnt].done = &done;
+      if (thread_create ("worker", PRI_DEFAULT, worker_thread,
+                         &workers[cnt]) == TID_ERROR)
+        break;
+    }
+  for (i = 0; i < cnt; i++)
+    sema_down (&done);
+  elapsed_us = (timer_ns () - begin) / 1000;
+  if (elapsed_us == 0)
+    elapsed_us = 1;
+
+  msg ("%s: %d threads, %llu us, %llu ops/ms", name, cnt, elapsed_us,
+       (uint64_t) cnt * OP_CNT * 1000 / elapsed_us);
+}
+
+static void
+worker_thread (void *worker_) 
+{
+  struct worker *w = worker_;
+  int op;
+
+  for (op = 0; op < OP_CNT; op++)
+    {
+      int slot = (w->id * 7 + op) % TABLE_SIZE;
+      bool write = (w->id + op) % WRITE_RATIO == 0;
+
+      if (!w->use_rwlock)
+        lock_acquire (&table_lock);
+      else if (write)
+        rw_write_acquire (&table_rwlock);
+      else
+        rw_read_acquire (&table_rwlock);
+
+      if (write)
+        table[slot]++;
+      else
+        (void) *(volatile int *) &table[slot];
+      thread_yield ();
+
+      if (!w->use_rwlock)
+        lock_release (&table_lock);
+      else if (write)
+        rw_write_release (&table_rwlock);
+      else
+        rw_read_release (&table_rwlock);
+    }
+  sema_up (w->done);
+}
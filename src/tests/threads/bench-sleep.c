@@ -0,0 +1,80 @@
+/* Measures how long the timer interrupt spends waking sleeping
+   threads as the number of sleepers grows.  For each thread
+   count, starts that many threads, each of which sleeps
+   ROUND_CNT times for varying numbers of ticks, and reports the
+   longest single wakeup pass seen meanwhile.
+
+   This is a benchmark, not a graded test.  Larger thread counts
+   need more kernel pool than the default memory size provides,
+   e.g. "pintos -m 16 -- run bench-sleep". */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ROUND_CNT 5
+
+/* Longest single sleep, in ticks. */
+#define MAX_SLEEP 50
+
+struct sleeper
+  {
+    int id;                     /* Sleeper ID. */
+    struct semaphore *done;     /* Upped when the sleeper finishes. */
+  };
+
+static thread_func sleeper_thread;
+
+/* Thread counts to measure. */
+static const int thread_cnts[] = {10, 50, 100, 250, 500};
+
+void
+test_bench_sleep (void) 
+{
+  static struct sleeper sleepers[500];
+  size_t i;
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++)
+    {
+      struct semaphore done;
+      int64_t start_ticks;
+      int cnt, j;
+
+      sema_init (&done, 0);
+      timer_wakeup_worst ();
+      start_ticks = timer_ticks ();
+      for (cnt = 0; cnt < thread_cnts[i]; cnt++)
+        {
+          sleepers[cnt].id = cnt;
+          sleepers[cnt].done = &done;
+          if (thread_create ("sleeper", PRI_DEFAULT, sleeper_thread,
+                             &sleepers[cnt]) == TID_ERROR)
+            break;
+        }
+      for (j = 0; j < cnt; j++)
+        sema_down (&done);
+
+      msg ("%d sleepers: %"PRId64" ticks, longest wakeup pass %llu cycles",
+           cnt, timer_elapsed (start_ticks), timer_wakeup_worst ());
+      if (cnt < thread_cnts[i])
+        {
+          msg ("out of memory after %d threads", cnt);
+          break;
+        }
+    }
+}
+
+static void
+sleeper_thread (void *sleeper_) 
+{
+  struct sleeper *sleeper = sleeper_;
+  int round;
+
+  for (round = 0; round < ROUND_CNT; round++)
+    timer_sleep (1 + (sleeper->id * 7 + round * 13) % MAX_SLEEP);
+  sema_up (sleeper->done);
+}
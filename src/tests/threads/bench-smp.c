@@ -0,0 +1,88 @@
+/* Measures scheduler throughput under a mix of CPU-bound and
+   yield-heavy threads.  For each N, starts N threads that each
+   spin through SPIN_CNT iterations and N threads that each yield
+   YIELD_CNT times, and reports the elapsed time and the number of
+   yields completed per millisecond.
+
+   Run it with different numbers of CPUs, as in "pintos --smp=4",
+   to see how the per-CPU run queues scale.  This is a benchmark, not a graded test. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+#include "threads/mp.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define SPIN_CNT 1000000
+#define YIELD_CNT 1000
+
+static thread_func spin_thread;
+static thread_func yield_thread;
+
+/* Values of N to measure. */
+static const int thread_cnts[] = {1, 2, 4, 8, 16};
+
+void
+test_bench_smp (void) 
+{
+  size_t i;
+  int j;
+
+  /* This benchmark does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d of %d CPUs running", cpu_started_cnt, cpu_cnt);
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++)
+    {
+      struct semaphore done;
+      uint64_t begin, elapsed_us;
+      int cnt;
+
+      sema_init (&done, 0);
+      begin = timer_ns ();
+      for (cnt = 0; cnt < thread_cnts[i]; cnt++)
+        if (thread_create ("spin", PRI_DEFAULT, spin_thread, &done)
+            == TID_ERROR
+            || thread_create ("yield", PRI_DEFAULT, yield_thread, &done)
+            == TID_ERROR)
+          break;
+      for (j = 0; j < 2 * cnt; j++)
+        sema_down (&done);
+      elapsed_us = (timer_ns () - begin) / 1000;
+      if (elapsed_us == 0)
+        elapsed_us = 1;
+
+      msg ("N=%d: %llu us, %llu yields/ms", cnt, elapsed_us,
+           (uint64_t) cnt * YIELD_CNT * 1000 / elapsed_us);
+      if (cnt < thread_cnts[i])
+        {
+          msg ("out of memory after %d threads", 2 * cnt);
+          break;
+        }
+    }
+}
+
+static void
+spin_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+  volatile int i;
+
+  for (i = 0; i < SPIN_CNT; i++)
+    continue;
+  sema_up (done);
+}
+
+static void
+yield_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+  sema_up (done);
+}
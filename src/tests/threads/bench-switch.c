@@ -0,0 +1,72 @@
+/* Measures the cost of a context switch as the number of ready
+   threads grows.  For each thread count, starts that many
+   threads at the same priority, each of which yields YIELD_CNT
+   times, and reports the average cycles per switch.
+
+   This is a benchmark, not a graded test.  Larger thread counts
+   need more kernel pool than the default memory size provides,
+   e.g. "pintos -m 16 -- run bench-switch". */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define YIELD_CNT 100
+
+static thread_func yield_thread;
+
+/* Thread counts to measure. */
+static const int thread_cnts[] = {2, 5, 10, 50, 100, 250, 500};
+
+void
+test_bench_switch (void) 
+{
+  size_t i;
+
+  /* This benchmark does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++)
+    {
+      struct semaphore start;
+      uint64_t begin, elapsed;
+      int cnt, j;
+
+      sema_init (&start, 0);
+      for (cnt = 0; cnt < thread_cnts[i]; cnt++)
+        if (thread_create ("yield", PRI_DEFAULT, yield_thread, &start)
+            == TID_ERROR)
+          break;
+
+      /* Release the threads, then drop below them so that we
+         run again only once they have all finished. */
+      for (j = 0; j < cnt; j++)
+        sema_up (&start);
+      begin = timer_cycles ();
+      thread_set_priority (PRI_MIN);
+      elapsed = timer_cycles () - begin;
+      thread_set_priority (PRI_DEFAULT);
+
+      msg ("%d threads: %llu cycles/switch", cnt,
+           elapsed / ((uint64_t) cnt * YIELD_CNT));
+      if (cnt < thread_cnts[i])
+        {
+          msg ("out of memory after %d threads", cnt);
+          break;
+        }
+    }
+}
+
+static void
+yield_thread (void *start_) 
+{
+  struct semaphore *start = start_;
+  int i;
+
+  sema_down (start);
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+}
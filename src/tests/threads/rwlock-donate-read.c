@@ -0,0 +1,60 @@
+/* The main thread acquires a readers-writer lock for writing.
+   Then it creates two higher-priority threads that block
+   acquiring it for reading, causing them to donate their
+   priorities to the main thread.  When the main thread releases
+   the lock, the readers should get it in priority order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader1_thread_func;
+static thread_func reader2_thread_func;
+
+void
+test_rwlock_donate_read (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_write_acquire (&rw);
+  thread_create ("reader1", PRI_DEFAULT + 1, reader1_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("reader2", PRI_DEFAULT + 2, reader2_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  rw_write_release (&rw);
+  msg ("reader2, reader1 must already have finished, in that order.");
+  msg ("This should be the last line before finishing this test.");
+}
+
+static void
+reader1_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader1: got the lock");
+  rw_read_release (rw);
+  msg ("reader1: done");
+}
+
+static void
+reader2_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader2: got the lock");
+  rw_read_release (rw);
+  msg ("reader2: done");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate-read) begin
+(rwlock-donate-read) This thread should have priority 32.  Actual priority: 32.
+(rwlock-donate-read) This thread should have priority 33.  Actual priority: 33.
+(rwlock-donate-read) reader2: got the lock
+(rwlock-donate-read) reader2: done
+(rwlock-donate-read) reader1: got the lock
+(rwlock-donate-read) reader1: done
+(rwlock-donate-read) reader2, reader1 must already have finished, in that order.
+(rwlock-donate-read) This should be the last line before finishing this test.
+(rwlock-donate-read) end
+EOF
+pass;
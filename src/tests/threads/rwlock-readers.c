@@ -0,0 +1,48 @@
+/* The main thread acquires a readers-writer lock for reading.
+   Then it creates a higher-priority thread that acquires the
+   same lock for reading, which must succeed without blocking
+   since readers share the lock.  Afterward the main thread, as
+   the only thread left, can acquire the lock for writing. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+
+void
+test_rwlock_readers (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("reader", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  msg ("reader must already have finished.");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  rw_read_release (&rw);
+
+  rw_write_acquire (&rw);
+  msg ("main: got the lock for writing");
+  rw_write_release (&rw);
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader: got the lock alongside main");
+  rw_read_release (rw);
+  msg ("reader: done");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-readers) begin
+(rwlock-readers) reader: got the lock alongside main
+(rwlock-readers) reader: done
+(rwlock-readers) reader must already have finished.
+(rwlock-readers) This thread should have priority 31.  Actual priority: 31.
+(rwlock-readers) main: got the lock for writing
+(rwlock-readers) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* The main thread acquires a readers-writer lock for reading.
+   Then it creates a writer, which blocks waiting for the main
+   thread to finish reading, and a higher-priority reader.  The
+   reader must queue behind the waiting writer instead of joining
+   the main thread, and donate its priority to the writer.  When
+   the main thread releases the lock, the writer should get it
+   first, then the reader. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+static thread_func reader_thread_func;
+
+void
+test_rwlock_writer_pref (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  thread_create ("reader", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  msg ("main: releasing the lock");
+  rw_read_release (&rw);
+  msg ("writer, reader must already have finished.");
+  msg ("This should be the last line before finishing this test.");
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("writer: got the lock with priority %d", thread_get_priority ());
+  rw_write_release (rw);
+  msg ("writer: done");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader: got the lock");
+  rw_read_release (rw);
+  msg ("reader: done");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) main: releasing the lock
+(rwlock-writer-pref) writer: got the lock with priority 33
+(rwlock-writer-pref) reader: got the lock
+(rwlock-writer-pref) reader: done
+(rwlock-writer-pref) writer: done
+(rwlock-writer-pref) writer, reader must already have finished.
+(rwlock-writer-pref) This should be the last line before finishing this test.
+(rwlock-writer-pref) end
+EOF
+pass;
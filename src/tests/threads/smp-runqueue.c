@@ -0,0 +1,114 @@
+/* Checks that a thread queued on a CPU's run queue runs on that
+   CPU or is stolen by another one.
+
+   First queues a thread on CPU 1, or on CPU 0 if only one CPU
+   runs, and checks that it ran on that CPU or that the steal
+   count went up.
+
+   Then queues lower-priority workers on the main thread's own
+   CPU and keeps that CPU busy for a second.  With more than one
+   CPU running, the other CPUs must steal and finish all of them
+   in that time; with one CPU, none may run until the main thread
+   blocks.
+
+   Run it with "pintos --smp=2" for the multiprocessor case. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mp.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WORKER_CNT 4
+
+struct record 
+  {
+    struct semaphore *done;     /* Upped when the thread has run. */
+    int cpu;                    /* CPU that ran the thread. */
+  };
+
+/* Number of threads that have finished. */
+static int finished;
+
+static thread_func record_cpu;
+
+void
+test_smp_runqueue (void) 
+{
+  struct semaphore done;
+  struct record queued, workers[WORKER_CNT];
+  long long steals;
+  int64_t start;
+  int home, self, spun;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+
+  /* A thread queued on another CPU. */
+  home = cpu_started_cnt > 1 ? 1 : 0;
+  steals = thread_steal_cnt ();
+  queued.done = &done;
+  thread_create_on (home, "queued", PRI_DEFAULT, record_cpu, &queued);
+  sema_down (&done);
+  if (queued.cpu != home && thread_steal_cnt () == steals)
+    fail ("thread queued on CPU %d ran on CPU %d without being stolen",
+          home, queued.cpu);
+  msg ("queued thread ran where it was queued or was stolen");
+
+  /* Workers queued behind a busy, higher-priority thread. */
+  self = thread_current ()->cpu;
+  steals = thread_steal_cnt ();
+  finished = 0;
+  for (i = 0; i < WORKER_CNT; i++)
+    {
+      workers[i].done = &done;
+      workers[i].cpu = -1;
+      thread_create_on (self, "worker", PRI_DEFAULT - 1, record_cpu,
+                        &workers[i]);
+    }
+  start = timer_ticks ();
+  while (timer_elapsed (start) < TIMER_FREQ && finished < WORKER_CNT)
+    barrier ();
+  spun = finished;
+  for (i = 0; i < WORKER_CNT; i++)
+    sema_down (&done);
+
+  if (cpu_started_cnt > 1)
+    {
+      if (spun != WORKER_CNT)
+        fail ("only %d of %d workers ran while their CPU was busy",
+              spun, WORKER_CNT);
+      for (i = 0; i < WORKER_CNT; i++)
+        if (workers[i].cpu == self)
+          fail ("worker %d ran on the busy CPU", i);
+      if (thread_steal_cnt () - steals < WORKER_CNT)
+        fail ("%lld steals for %d workers",
+              thread_steal_cnt () - steals, WORKER_CNT);
+    }
+  else if (spun != 0)
+    fail ("%d workers ran while a higher-priority thread was running",
+          spun);
+  msg ("workers behind a busy thread ran only where a CPU was free");
+}
+
+/* Records which CPU runs this thread. */
+static void
+record_cpu (void *record_) 
+{
+  struct record *record = record_;
+  enum intr_level old_level;
+
+  record->cpu = thread_current ()->cpu;
+
+  old_level = intr_disable ();
+  finished++;
+  intr_set_level (old_level);
+
+  sema_up (record->done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(smp-runqueue) begin
+(smp-runqueue) queued thread ran where it was queued or was stolen
+(smp-runqueue) workers behind a busy thread ran only where a CPU was free
+(smp-runqueue) end
+EOF
+pass;
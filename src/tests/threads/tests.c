@@ -29,6 +29,10 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"rwlock-donate-read", test_rwlock_donate_read},
+    {"rwlock-readers", test_rwlock_readers},
+    {"rwlock-writer-pref", test_rwlock_writer_pref},
+    {"smp-runqueue", test_smp_runqueue},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -38,6 +42,10 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"bench-switch", test_bench_switch},
+    {"bench-sleep", test_bench_sleep},
+    {"bench-smp", test_bench_smp},
+    {"bench-rwlock", test_bench_rwlock},
   };
 
 static const char *test_name;
@@ -23,6 +23,10 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_rwlock_donate_read;
+extern test_func test_rwlock_readers;
+extern test_func test_rwlock_writer_pref;
+extern test_func test_smp_runqueue;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -32,6 +36,10 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_bench_switch;
+extern test_func test_bench_sleep;
+extern test_func test_bench_smp;
+extern test_func test_bench_rwlock;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,28 @@
+/* Asks copy_range for more bytes than are left in the source.
+   Only the bytes up to end of file are copied, and copies that
+   start at or past end of file copy nothing. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int src, dst;
+
+  CHECK (create ("copy.txt", 0), "create \"copy.txt\"");
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((dst = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  seek (src, sizeof sample - 1 - 5);
+  CHECK (copy_range (src, dst, 100) == 5, "copy across end of file");
+  CHECK (copy_range (src, dst, 100) == 0, "copy at end of file");
+  seek (src, 1000);
+  CHECK (copy_range (src, dst, 100) == 0, "copy past end of file");
+  close (src);
+  close (dst);
+
+  check_file ("copy.txt", sample + sizeof sample - 1 - 5, 5);
+}
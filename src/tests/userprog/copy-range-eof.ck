@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-eof) begin
+(copy-range-eof) create "copy.txt"
+(copy-range-eof) open "sample.txt"
+(copy-range-eof) open "copy.txt"
+(copy-range-eof) copy across end of file
+(copy-range-eof) copy at end of file
+(copy-range-eof) copy past end of file
+(copy-range-eof) open "copy.txt" for verification
+(copy-range-eof) verified contents of "copy.txt"
+(copy-range-eof) close "copy.txt"
+(copy-range-eof) end
+copy-range-eof: exit(0)
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Passes copy_range lengths that overflow a file offset when
+   added to a nonzero position.  The copy must stop at end of
+   file instead of running past it. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int src, dst;
+
+  CHECK (create ("copy.txt", 0), "create \"copy.txt\"");
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((dst = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  seek (src, 1);
+  CHECK (copy_range (src, dst, 0x7fffffff) == sizeof sample - 2,
+         "copy 0x7fffffff bytes from offset 1");
+  seek (src, 1);
+  CHECK (copy_range (src, dst, 0xffffffff) == 0,
+         "copy 0xffffffff bytes from offset 1");
+  close (src);
+  close (dst);
+
+  check_file ("copy.txt", sample + 1, sizeof sample - 2);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-huge) begin
+(copy-range-huge) create "copy.txt"
+(copy-range-huge) open "sample.txt"
+(copy-range-huge) open "copy.txt"
+(copy-range-huge) copy 0x7fffffff bytes from offset 1
+(copy-range-huge) copy 0xffffffff bytes from offset 1
+(copy-range-huge) open "copy.txt" for verification
+(copy-range-huge) verified contents of "copy.txt"
+(copy-range-huge) close "copy.txt"
+(copy-range-huge) end
+copy-range-huge: exit(0)
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Copies part of a file from the middle with copy_range and
+   checks the copied bytes and both file positions. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int src, dst;
+
+  CHECK (create ("copy.txt", 0), "create \"copy.txt\"");
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((dst = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  seek (src, 10);
+  CHECK (copy_range (src, dst, 20) == 20, "copy 20 bytes from offset 10");
+  CHECK (tell (src) == 30, "source position advanced to 30");
+  CHECK (tell (dst) == 20, "destination position advanced to 20");
+  close (src);
+  close (dst);
+
+  check_file ("copy.txt", sample + 10, 20);
+}
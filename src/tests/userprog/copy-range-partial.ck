@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-partial) begin
+(copy-range-partial) create "copy.txt"
+(copy-range-partial) open "sample.txt"
+(copy-range-partial) open "copy.txt"
+(copy-range-partial) copy 20 bytes from offset 10
+(copy-range-partial) source position advanced to 30
+(copy-range-partial) destination position advanced to 20
+(copy-range-partial) open "copy.txt" for verification
+(copy-range-partial) verified contents of "copy.txt"
+(copy-range-partial) close "copy.txt"
+(copy-range-partial) end
+copy-range-partial: exit(0)
+EOF
+pass;
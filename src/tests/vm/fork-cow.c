@@ -0,0 +1,62 @@
+/* Checks that after fork() neither process sees what the other
+   writes to the memory they share copy-on-write, including
+   pages that were never written before the fork. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (8 * 4096)
+
+static char buf[SIZE];
+
+/* Returns true if all SIZE bytes at BUF + OFS equal C. */
+static bool
+all_equal (size_t ofs, size_t size, char c)
+{
+  size_t i;
+
+  for (i = ofs; i < ofs + size; i++)
+    if (buf[i] != c)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+  int status;
+
+  /* The second half is left untouched. */
+  memset (buf, 'p', SIZE / 2);
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      int fd;
+
+      /* Wait until the parent has written over its copy. */
+      while ((fd = open ("parent-wrote")) < 0)
+        continue;
+      close (fd);
+      if (!all_equal (0, SIZE / 2, 'p') || !all_equal (SIZE / 2, SIZE / 2, 0))
+        exit (1);
+      memset (buf, 'c', SIZE);
+      exit (all_equal (0, SIZE, 'c') ? 0 : 2);
+    }
+
+  /* Write over part of the data and part of the untouched half,
+     then let the child look. */
+  memset (buf, 'q', SIZE / 4);
+  memset (buf + SIZE * 3 / 4, 'q', SIZE / 4);
+  if (!create ("parent-wrote", 0))
+    fail ("create \"parent-wrote\"");
+  status = wait (pid);
+  CHECK (pid > 0 && status == 0, "child saw only its own writes");
+  CHECK (all_equal (0, SIZE / 4, 'q') && all_equal (SIZE / 4, SIZE / 4, 'p')
+         && all_equal (SIZE / 2, SIZE / 4, 0)
+         && all_equal (SIZE * 3 / 4, SIZE / 4, 'q'),
+         "parent saw only its own writes");
+}
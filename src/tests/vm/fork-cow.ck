@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow) begin
+fork-cow: exit(0)
+(fork-cow) child saw only its own writes
+(fork-cow) parent saw only its own writes
+(fork-cow) end
+fork-cow: exit(0)
+EOF
+pass;
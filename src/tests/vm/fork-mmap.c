@@ -0,0 +1,43 @@
+/* Forks while a file is mapped.  The child shares the mapping,
+   so it sees what the parent wrote through it before the fork,
+   and what the child writes through it reaches the file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  size_t len = strlen (sample);
+  char buf[1024];
+  int handle;
+  mapid_t map;
+  pid_t pid;
+  int status;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"sample.txt\"");
+  ACTUAL[0] = 'P';
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      if (ACTUAL[0] != 'P' || memcmp (ACTUAL + 1, sample + 1, len - 1))
+        exit (1);
+      ACTUAL[1] = 'C';
+      exit (0);
+    }
+
+  status = wait (pid);
+  CHECK (pid > 0 && status == 0, "child saw parent's write");
+  CHECK (read (handle, buf, len) == (int) len, "read \"sample.txt\"");
+  CHECK (buf[0] == 'P' && buf[1] == 'C' && !memcmp (buf + 2, sample + 2, len - 2),
+         "child's write reached the file");
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-mmap) begin
+(fork-mmap) open "sample.txt"
+(fork-mmap) mmap "sample.txt"
+fork-mmap: exit(0)
+(fork-mmap) child saw parent's write
+(fork-mmap) read "sample.txt"
+(fork-mmap) child's write reached the file
+(fork-mmap) end
+fork-mmap: exit(0)
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Forks a child that exits with a known status, and checks that
+   fork() returns 0 in the child and the child's pid in the
+   parent. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t pid = fork ();
+  int status;
+
+  if (pid == 0)
+    {
+      msg ("child run");
+      exit (81);
+    }
+
+  /* Wait before printing anything, so the child's output comes
+     first. */
+  status = wait (pid);
+  CHECK (pid > 0, "fork");
+  CHECK (status == 81, "wait for child");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-simple) begin
+(fork-simple) child run
+fork-simple: exit(81)
+(fork-simple) fork
+(fork-simple) wait for child
+(fork-simple) end
+fork-simple: exit(0)
+EOF
+pass;
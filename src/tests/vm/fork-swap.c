@@ -0,0 +1,64 @@
+/* Forks a process with more data than fits in memory alongside
+   the child's copy of it, so that shared and copied pages both
+   go through swap, and checks that each process keeps its own
+   data. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (1536 * 1024)
+
+static unsigned char buf[SIZE];
+
+/* Byte I of the data written by the process identified by
+   SEED.  Never zero, so the pages cannot be stored as zero
+   pages. */
+static unsigned char
+byte_at (size_t i, unsigned char seed)
+{
+  return (i * 7 + (i >> 12) + seed) | 1;
+}
+
+static void
+fill (unsigned char seed)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = byte_at (i, seed);
+}
+
+static bool
+verify (unsigned char seed)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != byte_at (i, seed))
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+  int status;
+
+  msg ("initialize");
+  fill (2);
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      if (!verify (2))
+        exit (1);
+      fill (4);
+      exit (verify (4) ? 0 : 2);
+    }
+
+  status = wait (pid);
+  CHECK (pid > 0 && status == 0, "child read parent's data and wrote its own");
+  CHECK (verify (2), "parent's data is unchanged");
+}
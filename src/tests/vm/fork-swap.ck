@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-swap) begin
+(fork-swap) initialize
+fork-swap: exit(0)
+(fork-swap) child read parent's data and wrote its own
+(fork-swap) parent's data is unchanged
+(fork-swap) end
+fork-swap: exit(0)
+EOF
+pass;
@@ -18,8 +18,10 @@
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/mp.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -38,7 +40,9 @@
 #endif
 #ifdef VM
 #include "vm/frame.h"
+#include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/zswap.h"
 #endif
 
 /* Amount of physical memory, in 4 kB pages. */
@@ -93,6 +97,7 @@ main (void)
   palloc_init ();
   malloc_init ();
   paging_init ();
+  mp_init ();
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -114,6 +119,7 @@ main (void)
   thread_start ();
   serial_init_queue ();
   timer_calibrate ();
+  mp_start ();
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -123,6 +129,7 @@ main (void)
 #ifdef VM
   frame_init();
   swap_init();
+  zswap_init();
 #endif
   printf ("Boot complete.\n");
   
@@ -253,9 +260,17 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-lockstat"))
+        lock_stats_enabled = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-zswap"))
+        zswap_pages = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -358,8 +373,13 @@ usage (void)
           "  -f                 Format file system disk during startup.\n"
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -tickless          Stop the timer tick while idle.\n"
+          "  -lockstat          Profile lock contention.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -zswap=COUNT       Keep up to COUNT pages of compressed swap.\n"
 #endif
           );
   power_off ();
@@ -396,6 +416,8 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  mp_print_stats ();
+  lock_print_stats ();
 #ifdef FILESYS
   disk_print_stats ();
 #endif
@@ -403,5 +425,11 @@ print_stats (void)
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  syscall_print_stats ();
+#endif
+#ifdef VM
+  page_print_stats ();
+  frame_print_stats ();
+  zswap_print_stats ();
 #endif
 }
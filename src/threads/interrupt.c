@@ -6,6 +6,7 @@
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/mp.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
@@ -31,9 +32,26 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
-static bool in_external_intr;   /* Are we processing an external interrupt? */
-static bool yield_on_return;    /* Should we yield on interrupt return? */
+   interrupt returns.  Each CPU keeps track of these in its
+   `in_external_intr' and `yield_on_return' members. */
+
+/* Interrupt lock.
+
+   The kernel was written for one CPU, where turning interrupts
+   off means that nothing else runs until they are turned back
+   on.  To keep that true with several CPUs, a CPU also holds
+   this lock whenever its interrupts are off, so that at most one
+   CPU at a time runs with interrupts off.  The lock belongs to
+   the CPU, not to a thread: it stays held across a thread
+   switch, which always happens with interrupts off, and is
+   released by whichever thread next turns interrupts on.
+
+   The BSP boots with interrupts off, so it starts out holding
+   the lock. */
+static volatile uint32_t intr_lock = 1;
+
+static void intr_lock_acquire (void);
+static void intr_lock_release (void);
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -77,6 +95,9 @@ intr_enable (void)
   enum intr_level old_level = intr_get_level ();
   ASSERT (!intr_context ());
 
+  if (old_level == INTR_OFF)
+    intr_lock_release ();
+
   /* Enable interrupts by setting the interrupt flag.
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -97,9 +118,59 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+  if (old_level == INTR_ON)
+    intr_lock_acquire ();
+
   return old_level;
 }
-
+
+/* Enables interrupts and waits for the next one, in a single
+   step.  Interrupts must be off.
+
+   The `sti' instruction disables interrupts until the
+   completion of the next instruction, so these two instructions
+   are executed atomically.  This atomicity is important;
+   otherwise, an interrupt could be handled between re-enabling
+   interrupts and waiting for the next one to occur, wasting as
+   much as one clock tick worth of time.
+
+   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
+   7.11.1 "HLT Instruction". */
+void
+intr_halt (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!intr_context ());
+
+  intr_lock_release ();
+  asm volatile ("sti; hlt" : : : "memory");
+}
+
+/* Atomically stores NEW in *ADDR and returns its old value. */
+static inline uint32_t
+atomic_xchg (volatile uint32_t *addr, uint32_t new)
+{
+  asm volatile ("lock xchgl %0, %1" : "+m" (*addr), "+r" (new) : : "memory");
+  return new;
+}
+
+/* Spins until this CPU holds the interrupt lock.  Interrupts
+   must be off. */
+static void
+intr_lock_acquire (void) 
+{
+  while (atomic_xchg (&intr_lock, 1) != 0)
+    asm volatile ("pause");
+}
+
+/* Releases the interrupt lock, which this CPU holds. */
+static void
+intr_lock_release (void) 
+{
+  ASSERT (intr_lock);
+  atomic_xchg (&intr_lock, 0);
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void)
@@ -144,6 +215,28 @@ intr_init (void)
   intr_names[19] = "#XF SIMD Floating-Point Exception";
 }
 
+/* Prepares an AP, which starts with interrupts off, to handle
+   interrupts: takes the interrupt lock and loads the IDT that
+   intr_init() built. */
+void
+intr_init_ap (void) 
+{
+  uint64_t idtr_operand;
+
+  intr_lock_acquire ();
+  idtr_operand = make_idtr_operand (sizeof idt - 1, idt);
+  asm volatile ("lidt %0" : : "m" (idtr_operand));
+}
+
+/* Returns true if VEC_NO is an external interrupt: one from the
+   PICs, at 0x20...0x2f, or from a local APIC, at 0xf0...0xfe. */
+static bool
+is_external (uint8_t vec_no) 
+{
+  return (vec_no >= 0x20 && vec_no <= 0x2f)
+         || (vec_no >= 0xf0 && vec_no <= 0xfe);
+}
+
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
    privilege level DPL.  Names the interrupt NAME for debugging
    purposes.  The interrupt handler will be invoked with
@@ -168,7 +261,7 @@ void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
                    const char *name) 
 {
-  ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+  ASSERT (is_external (vec_no));
   register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -189,7 +282,7 @@ void
 intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
                    intr_handler_func *handler, const char *name)
 {
-  ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+  ASSERT (!is_external (vec_no));
   register_handler (vec_no, dpl, level, handler, name);
 }
 
@@ -198,7 +291,7 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 bool
 intr_context (void) 
 {
-  return in_external_intr;
+  return intr_get_level () == INTR_OFF && cpu_current ()->in_external_intr;
 }
 
 /* During processing of an external interrupt, directs the
@@ -209,7 +302,7 @@ void
 intr_yield_on_return (void) 
 {
   ASSERT (intr_context ());
-  yield_on_return = true;
+  cpu_current ()->yield_on_return = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -340,19 +433,27 @@ intr_handler (struct intr_frame *frame)
 {
   bool external;
   intr_handler_func *handler;
+  struct cpu *cpu = NULL;
+
+  /* The interrupted code held the interrupt lock if it ran with
+     interrupts off.  If it did not, and the gate turned them off
+     for us, take the lock now. */
+  if (intr_get_level () == INTR_OFF && (frame->eflags & FLAG_IF))
+    intr_lock_acquire ();
 
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
-     and they need to be acknowledged on the PIC (see below).
-     An external interrupt handler cannot sleep. */
-  external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+     and they need to be acknowledged on the PIC or local APIC
+     (see below).  An external interrupt handler cannot sleep. */
+  external = is_external (frame->vec_no);
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
       ASSERT (!intr_context ());
 
-      in_external_intr = true;
-      yield_on_return = false;
+      cpu = cpu_current ();
+      cpu->in_external_intr = true;
+      cpu->yield_on_return = false;
     }
 
   /* Invoke the interrupt's handler. */
@@ -373,18 +474,33 @@ intr_handler (struct intr_frame *frame)
       PANIC ("Unexpected interrupt"); 
     }
 
-  /* Complete the processing of an external interrupt. */
+  /* Complete the processing of an external interrupt.  After
+     thread_yield() this thread may be running on another CPU, so
+     CPU must not be used past it. */
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
       ASSERT (intr_context ());
 
-      in_external_intr = false;
-      pic_end_of_interrupt (frame->vec_no); 
+      cpu->in_external_intr = false;
+      if (frame->vec_no <= 0x2f)
+        pic_end_of_interrupt (frame->vec_no); 
+      else
+        mp_end_of_interrupt ();
 
-      if (yield_on_return) 
+      if (cpu->yield_on_return) 
         thread_yield (); 
     }
+
+  /* Return with the interrupt lock held exactly if the
+     interrupted code held it. */
+  if (frame->eflags & FLAG_IF)
+    {
+      if (intr_get_level () == INTR_OFF)
+        intr_lock_release ();
+    }
+  else
+    intr_disable ();
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -0,0 +1,544 @@
+#include "threads/mp.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#endif
+
+/* Multiprocessor support.
+
+   The BIOS describes the machine's processors and interrupt
+   controllers in the tables of the Intel MultiProcessor
+   Specification.  We find those tables, record each CPU, and map
+   the local APIC so that a CPU can find out which one it is.
+
+   Once the timer works, mp_start() wakes the other processors
+   ("APs") with an INIT and two startup IPIs.  Each AP begins in
+   real mode in trampoline.S, turns on protected mode and paging,
+   and enters mp_ap_main() on the stack of its own idle thread.
+   From then on it schedules threads just like the bootstrap
+   processor (BSP), driven by its local APIC timer.  The PICs, and
+   so all device interrupts, stay wired to the BSP.
+
+   The rest of the kernel was written for one CPU and relies on
+   disabled interrupts for mutual exclusion.  interrupt.c keeps
+   that true by making a CPU that turns its interrupts off also
+   take the interrupt lock; see the comment there.
+
+   Refer to [MP-1.4] for the table formats and to [IA32-v3a]
+   chapter 8 "Advanced Programmable Interrupt Controller (APIC)"
+   for the local APIC. */
+
+/* MP floating pointer structure. */
+struct mp_fps
+  {
+    char signature[4];          /* "_MP_". */
+    uint32_t config;            /* Physical address of config table. */
+    uint8_t length;             /* Length in 16-byte units. */
+    uint8_t revision;           /* Specification revision. */
+    uint8_t checksum;           /* All bytes sum to 0. */
+    uint8_t type;               /* Default configuration, if nonzero. */
+    uint8_t features[4];        /* Feature bytes. */
+  }
+__attribute__ ((packed));
+
+/* MP configuration table header. */
+struct mp_config
+  {
+    char signature[4];          /* "PCMP". */
+    uint16_t length;            /* Base table length, with header. */
+    uint8_t revision;           /* Specification revision. */
+    uint8_t checksum;           /* Base table bytes sum to 0. */
+    char oem_id[8];             /* OEM name. */
+    char product_id[12];        /* Product name. */
+    uint32_t oem_table;         /* Physical address of OEM table. */
+    uint16_t oem_length;        /* Length of OEM table. */
+    uint16_t entry_cnt;         /* Number of entries after header. */
+    uint32_t lapic_addr;        /* Physical address of local APICs. */
+    uint16_t ext_length;        /* Extended table length. */
+    uint8_t ext_checksum;       /* Extended table checksum. */
+    uint8_t reserved;
+  }
+__attribute__ ((packed));
+
+/* MP configuration table processor entry. */
+struct mp_processor
+  {
+    uint8_t type;               /* MP_PROCESSOR. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    uint8_t apic_version;       /* Local APIC version. */
+    uint8_t flags;              /* MPP_* flags. */
+    uint32_t signature;         /* CPU signature. */
+    uint32_t features;          /* CPUID feature flags. */
+    uint32_t reserved[2];
+  }
+__attribute__ ((packed));
+
+/* MP configuration table I/O APIC entry. */
+struct mp_ioapic
+  {
+    uint8_t type;               /* MP_IOAPIC. */
+    uint8_t apic_id;            /* I/O APIC ID. */
+    uint8_t apic_version;       /* I/O APIC version. */
+    uint8_t flags;              /* Bit 0 set if usable. */
+    uint32_t addr;              /* Physical address. */
+  }
+__attribute__ ((packed));
+
+/* Configuration table entry types. */
+#define MP_PROCESSOR 0          /* 20 bytes. */
+#define MP_IOAPIC 2             /* 8 bytes, as are all other types. */
+
+/* Processor entry flags. */
+#define MPP_ENABLED 0x01        /* Usable. */
+#define MPP_BSP 0x02            /* Bootstrap processor. */
+
+/* Local APIC registers, as offsets in 32-bit words. */
+#define LAPIC_ID (0x020 / 4)    /* ID, in bits 24...31. */
+#define LAPIC_VER (0x030 / 4)   /* Version. */
+#define LAPIC_TPR (0x080 / 4)   /* Task priority. */
+#define LAPIC_EOI (0x0b0 / 4)   /* End of interrupt. */
+#define LAPIC_SVR (0x0f0 / 4)   /* Spurious interrupt vector. */
+#define LAPIC_ESR (0x280 / 4)   /* Error status. */
+#define LAPIC_ICRLO (0x300 / 4) /* Interrupt command, low word. */
+#define LAPIC_ICRHI (0x310 / 4) /* Interrupt command, high word. */
+#define LAPIC_TIMER (0x320 / 4) /* Local vector table: timer. */
+#define LAPIC_LINT0 (0x350 / 4) /* Local vector table: LINT0. */
+#define LAPIC_LINT1 (0x360 / 4) /* Local vector table: LINT1. */
+#define LAPIC_TICR (0x380 / 4)  /* Timer initial count. */
+#define LAPIC_TCCR (0x390 / 4)  /* Timer current count. */
+#define LAPIC_TDCR (0x3e0 / 4)  /* Timer divide configuration. */
+
+/* Register bits. */
+#define LAPIC_ENABLE 0x00000100 /* SVR: APIC software enable. */
+#define LAPIC_MASKED 0x00010000 /* LVT: interrupt masked. */
+#define LAPIC_PERIODIC 0x00020000 /* TIMER: periodic mode. */
+#define LAPIC_DIV16 0x3         /* TDCR: divide bus clock by 16. */
+#define ICR_INIT 0x00000500     /* ICR: INIT delivery mode. */
+#define ICR_STARTUP 0x00000600  /* ICR: startup delivery mode. */
+#define ICR_DELIVS 0x00001000   /* ICR: delivery pending. */
+#define ICR_ASSERT 0x00004000   /* ICR: level assert. */
+#define ICR_LEVEL 0x00008000    /* ICR: level triggered. */
+
+/* Kernel virtual address where the local APIC is mapped.  This
+   is the same as its usual physical address, far above the
+   kernel's mapping of RAM. */
+#define LAPIC_VADDR 0xfee00000
+
+/* Physical address where APs start executing, in real mode.  A
+   startup IPI can only name a page below 1 MB; this one is free,
+   between the loader at 0x7c00 and the loader's page tables at
+   0x10000. */
+#define AP_TRAMPOLINE 0x8000
+
+/* CPUs found, in configuration table order, except that the BSP
+   is always cpus[0]. */
+struct cpu cpus[CPU_MAX];
+int cpu_cnt;
+
+/* Number of CPUs with `started' set. */
+int cpu_started_cnt;
+
+/* Set before the first AP starts.  Until then, cpu_current() can
+   skip asking the local APIC, which is slow in emulators. */
+static bool smp;
+
+/* Local APIC timer initial count that yields TIMER_FREQ
+   interrupts per second, measured by lapic_timer_calibrate(). */
+static uint32_t lapic_timer_count;
+
+/* Stack pointer for the AP being started, read by trampoline.S. */
+void *mp_ap_stack;
+
+/* The trampoline, in trampoline.S.  ap_cr3 is the slot in it for
+   the page directory that the AP starts with. */
+extern const char ap_trampoline[], ap_trampoline_end[];
+extern uint32_t ap_cr3;
+
+/* Local APIC registers, or NULL if there is no MP table. */
+static volatile uint32_t *lapic;
+
+/* Physical address of the first I/O APIC, or 0 if none. */
+static uint32_t ioapic_addr;
+
+/* Returns the sum of the LENGTH bytes at P. */
+static uint8_t
+sum (const void *p, size_t length)
+{
+  const uint8_t *bytes = p;
+  uint8_t sum = 0;
+  size_t i;
+
+  for (i = 0; i < length; i++)
+    sum += bytes[i];
+  return sum;
+}
+
+/* Looks for an MP floating pointer structure in the LENGTH bytes
+   of physical memory at PADDR. */
+static struct mp_fps *
+search_fps (uintptr_t paddr, size_t length)
+{
+  uint8_t *p = ptov (paddr);
+  uint8_t *end = p + length;
+
+  for (; p < end; p += sizeof (struct mp_fps))
+    if (!memcmp (p, "_MP_", 4) && sum (p, sizeof (struct mp_fps)) == 0)
+      return (struct mp_fps *) p;
+  return NULL;
+}
+
+/* Finds the MP floating pointer structure in the first kilobyte
+   of the extended BIOS data area, the last kilobyte of base
+   memory, or the BIOS ROM, in that order. */
+static struct mp_fps *
+find_fps (void)
+{
+  uint8_t *bda = ptov (0x400);
+  uintptr_t ebda = (bda[0x0f] << 8 | bda[0x0e]) << 4;
+  uintptr_t base_top = (bda[0x14] << 8 | bda[0x13]) * 1024;
+  struct mp_fps *fps = NULL;
+
+  if (ebda != 0)
+    fps = search_fps (ebda, 1024);
+  if (fps == NULL && base_top >= 1024)
+    fps = search_fps (base_top - 1024, 1024);
+  if (fps == NULL)
+    fps = search_fps (0xf0000, 0x10000);
+  return fps;
+}
+
+/* Maps the 4 kB of local APIC registers at physical address
+   PADDR into the kernel page table, uncached, at LAPIC_VADDR.
+   Process page directories copy the kernel's page directory
+   entries, so this must run before any process starts. */
+static void
+map_lapic (uintptr_t paddr)
+{
+  uint32_t *pde = &base_page_dir[pd_no ((void *) LAPIC_VADDR)];
+  uint32_t *pt;
+
+  ASSERT (*pde == 0);
+  pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  *pde = pde_create (pt);
+  pt[pt_no ((void *) LAPIC_VADDR)] = (paddr & PTE_ADDR) | PTE_PCD | PTE_PWT
+                                     | PTE_W | PTE_P;
+  lapic = (volatile uint32_t *) LAPIC_VADDR;
+}
+
+/* Reads the MP configuration table, if any, into cpus[].
+   Without one, the machine is a uniprocessor and cpus[0] stands
+   for its only CPU. */
+void
+mp_init (void) 
+{
+  struct mp_fps *fps = find_fps ();
+  struct mp_config *config;
+  uint8_t *entry;
+  int i;
+
+  cpus[0].bsp = cpus[0].started = true;
+  cpu_cnt = cpu_started_cnt = 1;
+
+  if (fps == NULL || fps->config == 0
+      || fps->config >= ram_pages * PGSIZE)
+    return;
+  config = ptov (fps->config);
+  if (memcmp (config->signature, "PCMP", 4)
+      || sum (config, config->length) != 0)
+    return;
+
+  cpu_cnt = 0;
+  entry = (uint8_t *) (config + 1);
+  for (i = 0; i < config->entry_cnt; i++)
+    if (*entry == MP_PROCESSOR)
+      {
+        struct mp_processor *p = (struct mp_processor *) entry;
+        if ((p->flags & MPP_ENABLED) && cpu_cnt < CPU_MAX)
+          {
+            struct cpu *cpu = &cpus[cpu_cnt++];
+            cpu->apic_id = p->apic_id;
+            cpu->bsp = (p->flags & MPP_BSP) != 0;
+            cpu->started = cpu->bsp;
+
+            /* Keep the BSP in cpus[0]: threads created before
+               mp_init() already run there as CPU 0, and
+               thread_init() has set up cpus[0]'s thread fields. */
+            if (cpu->bsp && cpu != &cpus[0])
+              {
+                uint8_t apic_id = cpus[0].apic_id;
+                cpus[0].apic_id = cpu->apic_id;
+                cpu->apic_id = apic_id;
+                cpu->bsp = cpu->started = false;
+                cpus[0].bsp = cpus[0].started = true;
+              }
+          }
+        entry += sizeof *p;
+      }
+    else
+      {
+        if (*entry == MP_IOAPIC && ioapic_addr == 0)
+          ioapic_addr = ((struct mp_ioapic *) entry)->addr;
+        entry += 8;
+      }
+
+  if (cpu_cnt == 0)
+    {
+      cpus[0].bsp = cpus[0].started = true;
+      cpu_cnt = 1;
+      return;
+    }
+  map_lapic (config->lapic_addr);
+}
+
+/* Enables this CPU's local APIC.  The BIOS already wired the
+   BSP's LINT0 to the PICs, so there we leave the local vector
+   table alone; an AP masks its LINT pins, since device
+   interrupts only go to the BSP. */
+static void
+lapic_init (bool bsp) 
+{
+  lapic[LAPIC_SVR] = LAPIC_ENABLE | LAPIC_SPURIOUS_VEC;
+  if (!bsp)
+    {
+      lapic[LAPIC_LINT0] = LAPIC_MASKED;
+      lapic[LAPIC_LINT1] = LAPIC_MASKED;
+    }
+
+  /* Clear errors, which takes two writes, and any interrupt
+     still in service.  Accept interrupts of every priority. */
+  lapic[LAPIC_ESR] = 0;
+  lapic[LAPIC_ESR] = 0;
+  lapic[LAPIC_EOI] = 0;
+  lapic[LAPIC_TPR] = 0;
+}
+
+/* Sends the interrupt command ICR_LO to the CPU with local APIC
+   ID APIC_ID and waits for it to be delivered. */
+static void
+lapic_send (uint8_t apic_id, uint32_t icr_lo) 
+{
+  lapic[LAPIC_ICRHI] = (uint32_t) apic_id << 24;
+  lapic[LAPIC_ICRLO] = icr_lo;
+  while (lapic[LAPIC_ICRLO] & ICR_DELIVS)
+    continue;
+}
+
+/* Measures how far the local APIC timer counts down in one
+   timer tick, with the same divider that APs use.  Interrupts
+   must be on, so that the PIT keeps ticking. */
+static void
+lapic_timer_calibrate (void) 
+{
+  int64_t start;
+
+  ASSERT (intr_get_level () == INTR_ON);
+
+  lapic[LAPIC_TDCR] = LAPIC_DIV16;
+  lapic[LAPIC_TIMER] = LAPIC_MASKED | LAPIC_TIMER_VEC;
+
+  /* Wait for a timer tick to start, then count down from the
+     top for TIMER_FREQ / 10 ticks. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    barrier ();
+  start++;
+  lapic[LAPIC_TICR] = 0xffffffff;
+  while (timer_elapsed (start) < TIMER_FREQ / 10)
+    barrier ();
+  lapic_timer_count = (0xffffffff - lapic[LAPIC_TCCR]) / (TIMER_FREQ / 10);
+  lapic[LAPIC_TICR] = 0;
+}
+
+/* Starts this CPU's local APIC timer, interrupting TIMER_FREQ
+   times per second. */
+static void
+lapic_timer_start (void) 
+{
+  lapic[LAPIC_TDCR] = LAPIC_DIV16;
+  lapic[LAPIC_TIMER] = LAPIC_PERIODIC | LAPIC_TIMER_VEC;
+  lapic[LAPIC_TICR] = lapic_timer_count;
+}
+
+/* Local APIC timer interrupt handler, which only APs receive.
+   The BSP still ticks from the PIT, which also drives the
+   global timer_ticks() and the sleep wheel. */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) 
+{
+  cpu_current ()->ticks++;
+  thread_tick ();
+}
+
+/* Reschedule IPI handler.  Another CPU made a thread ready that
+   this one should run. */
+static void
+resched_interrupt (struct intr_frame *args UNUSED) 
+{
+  thread_preempt ();
+}
+
+/* Spurious local APIC interrupt handler.  Needs no EOI. */
+static void
+spurious_interrupt (struct intr_frame *args UNUSED) 
+{
+}
+
+/* Acknowledges a local APIC interrupt.  Called by
+   intr_handler(). */
+void
+mp_end_of_interrupt (void) 
+{
+  lapic[LAPIC_EOI] = 0;
+}
+
+/* Interrupts CPU so that it reconsiders which thread to run. */
+void
+mp_reschedule (int cpu) 
+{
+  ASSERT (cpu >= 0 && cpu < cpu_cnt && cpus[cpu].started);
+  lapic_send (cpus[cpu].apic_id, LAPIC_RESCHED_VEC);
+}
+
+/* Wakes up AP CPU, with its idle thread IDLE, and waits up to a
+   second for it to reach mp_ap_main().  Returns true if it
+   did. */
+static bool
+start_ap (int cpu, struct thread *idle) 
+{
+  uint8_t apic_id = cpus[cpu].apic_id;
+  int64_t start;
+  int i;
+
+  mp_ap_stack = (uint8_t *) idle + PGSIZE;
+
+  /* INIT, then two startup IPIs, as [MP-1.4] appendix B.4
+     prescribes.  The startup IPI's vector is the page number of
+     the code to run. */
+  lapic_send (apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+  timer_usleep (200);
+  lapic_send (apic_id, ICR_INIT | ICR_LEVEL);
+  timer_msleep (10);
+  for (i = 0; i < 2; i++)
+    {
+      lapic_send (apic_id, ICR_STARTUP | (AP_TRAMPOLINE >> 12));
+      timer_usleep (200);
+    }
+
+  start = timer_ticks ();
+  while (!cpus[cpu].started && timer_elapsed (start) < TIMER_FREQ)
+    barrier ();
+  return cpus[cpu].started;
+}
+
+/* Starts the APs.  Must be called after the timer has been
+   calibrated, with interrupts on. */
+void
+mp_start (void) 
+{
+  uint32_t *ap_pd;
+  bool all_started = true;
+  int i;
+
+  ASSERT (intr_get_level () == INTR_ON);
+
+  if (cpu_cnt < 2)
+    return;
+
+  intr_register_int (LAPIC_SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+                     "APIC spurious");
+  intr_register_ext (LAPIC_TIMER_VEC, lapic_timer_interrupt, "APIC timer");
+  intr_register_ext (LAPIC_RESCHED_VEC, resched_interrupt, "Reschedule IPI");
+  smp = true;
+  lapic_init (true);
+  lapic_timer_calibrate ();
+
+  /* An AP turns on paging while it still executes the trampoline
+     at its physical address, so the page directory it starts with
+     maps the low 4 MB both there and at LOADER_PHYS_BASE.
+     mp_ap_main() then switches to base_page_dir. */
+  ap_pd = palloc_get_page (PAL_ASSERT);
+  memcpy (ap_pd, base_page_dir, PGSIZE);
+  ap_pd[0] = ap_pd[pd_no (ptov (0))];
+  memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+          ap_trampoline_end - ap_trampoline);
+  *(uint32_t *) ptov (AP_TRAMPOLINE + ((char *) &ap_cr3 - ap_trampoline))
+    = vtop (ap_pd);
+
+  for (i = 1; i < cpu_cnt; i++)
+    if (!start_ap (i, thread_create_idle (i)))
+      {
+        /* The AP may still wake up later on mp_ap_stack and
+           ap_pd, so leave both alone and give up on the rest. */
+        printf ("MP: CPU %d (APIC %d) did not start\n",
+                i, cpus[i].apic_id);
+        all_started = false;
+        break;
+      }
+  if (all_started)
+    palloc_free_page (ap_pd);
+}
+
+/* An AP's first C code, called by trampoline.S with interrupts
+   off, on the stack of the idle thread that mp_start() made for
+   it. */
+void
+mp_ap_main (void) 
+{
+  struct cpu *cpu;
+
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (base_page_dir)) : "memory");
+  intr_init_ap ();
+#ifdef USERPROG
+  gdt_load ();
+#endif
+  lapic_init (false);
+  lapic_timer_start ();
+
+  cpu = cpu_current ();
+  cpu->started = true;
+  cpu_started_cnt++;
+  thread_start_ap ();
+}
+
+/* Returns the CPU running this code. */
+struct cpu *
+cpu_current (void) 
+{
+  if (smp)
+    {
+      uint8_t apic_id = lapic[LAPIC_ID] >> 24;
+      int i;
+
+      for (i = 0; i < cpu_cnt; i++)
+        if (cpus[i].apic_id == apic_id)
+          return &cpus[i];
+    }
+  return &cpus[0];
+}
+
+/* Prints what mp_init() found. */
+void
+mp_print_stats (void) 
+{
+  int started = 0;
+  int i;
+
+  for (i = 0; i < cpu_cnt; i++)
+    if (cpus[i].started)
+      started++;
+  printf ("MP: %d CPUs, %d running", cpu_cnt, started);
+  if (lapic != NULL)
+    printf (", local APIC version %#x", (unsigned) (lapic[LAPIC_VER] & 0xff));
+  if (ioapic_addr != 0)
+    printf (", I/O APIC at %#x", (unsigned) ioapic_addr);
+  printf ("\n");
+}
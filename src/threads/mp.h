@@ -0,0 +1,49 @@
+#ifndef THREADS_MP_H
+#define THREADS_MP_H
+
+#include <debug.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Most CPUs we keep track of. */
+#define CPU_MAX 8
+
+/* Interrupt vectors raised by a CPU's local APIC.  0xf0...0xfe
+   are external interrupts, like the PIC's 0x20...0x2f; 0xff is
+   the spurious vector, which needs no end-of-interrupt. */
+#define LAPIC_TIMER_VEC 0xf0    /* Local APIC timer. */
+#define LAPIC_RESCHED_VEC 0xf1  /* Reschedule IPI. */
+#define LAPIC_SPURIOUS_VEC 0xff /* Spurious interrupt. */
+
+struct thread;
+
+/* A CPU, as described by the BIOS's MP configuration table, plus
+   the state the kernel keeps for each CPU. */
+struct cpu
+  {
+    uint8_t apic_id;            /* Local APIC ID. */
+    bool bsp;                   /* Bootstrap processor? */
+    bool started;               /* Running kernel code? */
+
+    /* Owned by the interrupt and thread code. */
+    bool in_external_intr;      /* Processing an external interrupt? */
+    bool yield_on_return;       /* Yield on interrupt return? */
+    struct thread *current;     /* Running thread. */
+    struct thread *idle_thread; /* This CPU's idle thread. */
+    unsigned thread_ticks;      /* Timer ticks since last yield. */
+    int64_t ticks;              /* Local APIC timer ticks. */
+  };
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+extern int cpu_started_cnt;
+
+void mp_init (void);
+void mp_start (void);
+void mp_ap_main (void) NO_RETURN;
+struct cpu *cpu_current (void);
+void mp_end_of_interrupt (void);
+void mp_reschedule (int cpu);
+void mp_print_stats (void);
+
+#endif /* threads/mp.h */
@@ -31,18 +31,9 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
 
 //#define DEBUG
-/* lock이 들고 있는 최대치의 priority(lock->lock_max_priority) 순서대로 정렬하기 위한 보조 함수 */
-static bool 
-lock_set_priority_list (const struct list_elem* a_, const struct list_elem* b_,
-               void* aux UNUSED)
-{
-  const struct lock* a = list_entry(a_, struct lock, elem);
-  const struct lock* b = list_entry(b_, struct lock, elem);
-
-  return a->lock_priority > b->lock_priority;
-}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -174,6 +165,131 @@ sema_test_helper (void *sema_)
     }
 }
 
+/* Lock profiling, enabled by the -lockstat kernel option.
+
+   Locks are grouped into classes by the name they were
+   initialized with, so that, for example, every malloc
+   descriptor's lock is counted together. */
+bool lock_stats_enabled;
+
+/* Maximum number of lock classes. */
+#define LOCK_CLASS_MAX 64
+
+static struct lock_class lock_classes[LOCK_CLASS_MAX];
+static int lock_class_cnt;
+
+/* Returns the class named NAME, creating it if necessary, or a
+   null pointer if the class table is full. */
+static struct lock_class *
+lock_class_lookup (const char *name)
+{
+  struct lock_class *c;
+  enum intr_level old_level;
+
+  if (*name == '&')
+    name++;
+
+  old_level = intr_disable ();
+  for (c = lock_classes; c < lock_classes + lock_class_cnt; c++)
+    if (c->name == name || !strcmp (c->name, name))
+      break;
+  if (c == lock_classes + LOCK_CLASS_MAX)
+    c = NULL;
+  else if (c == lock_classes + lock_class_cnt)
+    {
+      c->name = name;
+      lock_class_cnt++;
+    }
+  intr_set_level (old_level);
+  return c;
+}
+
+/* Records that the current thread acquired LOCK after waiting
+   since cycle START, from the code that called the acquiring
+   function at SITE.  CONTENDED is true if LOCK was held by
+   another thread when we tried to take it.  Interrupts must be
+   off. */
+static void
+lock_stat_acquired (struct lock *lock, uint64_t start, bool contended,
+                    void *site)
+{
+  struct lock_class *c = lock->class;
+  uint64_t now;
+
+  if (c == NULL)
+    return;
+
+  now = timer_cycles ();
+  lock->acquired_at = now;
+  c->acquired++;
+  if (contended)
+    {
+      uint64_t wait = now - start;
+
+      c->contended++;
+      c->wait_cycles += wait;
+      if (wait > c->max_wait_cycles)
+        {
+          c->max_wait_cycles = wait;
+          c->max_wait_site = site;
+        }
+    }
+}
+
+/* Records that the current thread is releasing LOCK.
+   Interrupts must be off. */
+static void
+lock_stat_released (struct lock *lock)
+{
+  struct lock_class *c = lock->class;
+  uint64_t hold;
+
+  if (c == NULL)
+    return;
+
+  hold = timer_cycles () - lock->acquired_at;
+  if (hold > c->max_hold_cycles)
+    c->max_hold_cycles = hold;
+}
+
+/* Prints lock statistics, lock classes with the most total wait
+   first. */
+void
+lock_print_stats (void)
+{
+  struct lock_class *sorted[LOCK_CLASS_MAX];
+  int i, j;
+
+  if (!lock_stats_enabled)
+    return;
+
+  /* Insertion sort by descending wait_cycles. */
+  for (i = 0; i < lock_class_cnt; i++)
+    {
+      struct lock_class *c = &lock_classes[i];
+
+      for (j = i; j > 0 && sorted[j - 1]->wait_cycles < c->wait_cycles; j--)
+        sorted[j] = sorted[j - 1];
+      sorted[j] = c;
+    }
+
+  for (i = 0; i < lock_class_cnt; i++)
+    {
+      struct lock_class *c = sorted[i];
+
+      if (c->acquired == 0)
+        continue;
+      printf ("Lock %s: %llu acquired, %llu contended, %llu wait cycles, "
+              "max hold %llu cycles",
+              c->name, c->acquired, c->contended, c->wait_cycles,
+              c->max_hold_cycles);
+      if (c->max_wait_site != NULL)
+        printf (", longest wait %llu cycles from %p",
+                c->max_wait_cycles, c->max_wait_site);
+      printf ("\n");
+    }
+}
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -188,51 +304,94 @@ sema_test_helper (void *sema_)
    another one "up" it, but with a lock the same thread must both
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   instead of a lock.
+
+   NAME identifies the lock in the -lockstat report.  The
+   lock_init() macro in synch.h passes the text of its argument. */
 void
-lock_init (struct lock *lock)
+lock_init_named (struct lock *lock, const char *name)
 {
   ASSERT (lock != NULL);
+  ASSERT (name != NULL);
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+  lock->lock_priority = -1;
+  lock->class = lock_stats_enabled ? lock_class_lookup (name) : NULL;
 }
 
-/* priority donation */
+/* Donates T's priority along the chain of locks it waits for:
+   to the holder of T's lock, then to the holder of the lock that
+   one waits for, and so on, for at most DONATE_DEPTH_MAX links.
+   Each lock's lock_priority tracks the highest priority among
+   its waiters and is counted once in its holder's donations. */
 void
-donate_priority(struct thread* curr_thread) 
+donate_priority (struct thread *t) 
 {
   enum intr_level old_level = intr_disable ();
+  int depth;
 
-  /* 현재 요청한 lock의 유효성 검사 */
-  struct lock* curr_lock = curr_thread->acquiring_lock;
-  if (curr_lock == NULL || curr_lock->holder == NULL) {
-    intr_set_level (old_level);
-    return;
-  }
-
-  /* lock holder */
-  struct thread* curr_owner = curr_lock->holder;
-  if (curr_thread->priority > curr_owner->priority)
-  {
-
-    curr_owner->priority = curr_thread->priority;
+  for (depth = 0; depth < DONATE_DEPTH_MAX; depth++)
+    {
+      struct lock *lock = t->acquiring_lock;
+      struct thread *holder;
+
+      /* 더 올려줄 것이 없으면 chain 끝 */
+      if (lock == NULL || lock->holder == NULL
+          || t->priority <= lock->lock_priority)
+        break;
+
+      holder = lock->holder;
+      if (lock->lock_priority >= 0)
+        thread_donation_remove (holder, lock->lock_priority);
+      lock->lock_priority = t->priority;
+      thread_donation_add (holder, lock->lock_priority);
+
+      /* holder가 ready 상태라면 ready list도 옮겨진다 */
+      thread_reset_priority (holder);
+      t = holder;
+    }
 
-  } else {
-    /* 도네이션 일어나지 않음 */
-    intr_set_level (old_level);
-    return;
+  intr_set_level (old_level);
+}
 
-  }
+/* Returns the highest priority among the threads waiting for
+   LOCK, or -1 if no thread is waiting. */
+static int
+lock_waiters_priority (struct lock *lock) 
+{
+  struct list *waiters = &lock->semaphore.waiters;
+  struct list_elem *e;
+  int priority = -1;
 
-  /* nested donation */
-  if (curr_owner->acquiring_lock != NULL && curr_owner->acquiring_lock->lock_priority < curr_thread->priority)
-    curr_owner->acquiring_lock->lock_priority = curr_thread->priority;
+  for (e = list_begin (waiters); e != list_end (waiters); e = list_next (e))
+    {
+      const struct thread *t = list_entry (e, struct thread, elem);
+      if (t->priority > priority)
+        priority = t->priority;
+    }
+  return priority;
+}
 
-  donate_priority(curr_owner);
-  intr_set_level (old_level);
+/* Makes the current thread, which has just downed LOCK's
+   semaphore, LOCK's holder.  Threads still waiting for LOCK
+   donate to the new holder.  Interrupts must be off. */
+static void
+lock_take (struct lock *lock) 
+{
+  struct thread *t = thread_current ();
 
+  lock->holder = t;
+  if (thread_mlfqs)
+    return;
 
+  list_push_back (&t->lock_list, &lock->elem);
+  lock->lock_priority = lock_waiters_priority (lock);
+  if (lock->lock_priority >= 0)
+    {
+      thread_donation_add (t, lock->lock_priority);
+      thread_reset_priority (t);
+    }
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -255,34 +414,21 @@ lock_acquire (struct lock *lock)
   enum intr_level old_level = intr_disable();
 
   struct thread* curr_thread = thread_current ();
-  curr_thread->acquiring_lock = lock;
+  void *site = __builtin_return_address (0);
+  bool contended = lock->semaphore.value == 0;
+  uint64_t start = lock->class != NULL ? timer_cycles () : 0;
 
-  /* lock priority donation */
-  if(curr_thread->priority > lock->lock_priority)
+  /* The MLFQS does not use priority donation. */
+  if (!thread_mlfqs)
   {
-
-    lock->lock_priority = curr_thread->priority;
-
+    curr_thread->acquiring_lock = lock;
+    donate_priority (curr_thread);
   }
 
-  donate_priority(curr_thread);
-
-
   sema_down (&lock->semaphore);
-  lock->holder = curr_thread;
   curr_thread->acquiring_lock = NULL;
-  lock->lock_priority = curr_thread->priority;
-
-  list_insert_ordered(&curr_thread->lock_list, &lock->elem, lock_set_priority_list, NULL);
-  
-  if (lock->lock_priority > curr_thread->priority)
-  {
-    curr_thread->priority = lock->lock_priority;
-
-    /* 만약, ready list에서 priority가 큰 것이 있다면, 먼저 실행 */
-    thread_preempt();
-  }
-
+  lock_take (lock);
+  lock_stat_acquired (lock, start, contended, site);
 
   intr_set_level(old_level);
 }
@@ -302,9 +448,14 @@ lock_try_acquire (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock_take (lock);
+      lock_stat_acquired (lock, 0, false, NULL);
+    }
+  intr_set_level (old_level);
   return success;
   
 }
@@ -324,8 +475,15 @@ lock_release (struct lock *lock)
   /* TODO : Rollback 짜야돼 */
   enum intr_level old_level = intr_disable();
 
-  list_remove (&lock->elem);
-  thread_reset_priority(lock->holder); 
+  lock_stat_released (lock);
+  if (!thread_mlfqs)
+  {
+    list_remove (&lock->elem);
+    if (lock->lock_priority >= 0)
+      thread_donation_remove (lock->holder, lock->lock_priority);
+    lock->lock_priority = -1;
+    thread_reset_priority (lock->holder);
+  }
 
 
   lock->holder = NULL;
@@ -480,3 +638,141 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW as unheld.
+
+   A readers-writer lock admits any number of readers at once
+   or a single writer.  The writer holds RW's inner lock for its
+   whole critical section; a reader takes the inner lock only
+   long enough to register itself.  So a reader that arrives
+   while a writer holds or waits for RW blocks on an ordinary
+   lock and donates its priority to the writer, and a waiting
+   writer keeps new readers out, which means a stream of readers
+   cannot starve it.  A writer waiting for readers to drain does
+   not donate to them. */
+void
+rw_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  rw->readers = 0;
+  rw->writer_waiting = false;
+  sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   waits for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+  rw->readers++;
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out wakes a waiting writer. */
+void
+rw_read_release (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (rw->readers > 0);
+  if (--rw->readers == 0 && rw->writer_waiting)
+    sema_up (&rw->drained);
+  intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  New readers are held off from the moment this thread
+   takes the inner lock.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+
+  old_level = intr_disable ();
+  while (rw->readers > 0)
+    {
+      rw->writer_waiting = true;
+      sema_down (&rw->drained);
+    }
+  rw->writer_waiting = false;
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for
+   writing. */
+void
+rw_write_release (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_release (&rw->lock);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool
+rw_write_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return lock_held_by_current_thread (&rw->lock);
+}
+
+/* Initializes spinlock L as unheld. */
+void
+spinlock_init (struct spinlock *l) 
+{
+  l->locked = 0;
+}
+
+/* Atomically stores NEW in *ADDR and returns its old value. */
+static inline uint32_t
+atomic_xchg (volatile uint32_t *addr, uint32_t new)
+{
+  asm volatile ("lock xchgl %0, %1" : "+m" (*addr), "+r" (new) : : "memory");
+  return new;
+}
+
+/* Disables interrupts and busy-waits until L is free, then
+   acquires it. */
+void
+spinlock_acquire (struct spinlock *l) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  while (atomic_xchg (&l->locked, 1) != 0)
+    asm volatile ("pause");
+  l->old_level = old_level;
+}
+
+/* Releases L, which the current CPU must hold, and restores the
+   interrupt level from before spinlock_acquire(). */
+void
+spinlock_release (struct spinlock *l) 
+{
+  enum intr_level old_level = l->old_level;
+
+  ASSERT (l->locked);
+  atomic_xchg (&l->locked, 0);
+  intr_set_level (old_level);
+}
@@ -3,6 +3,8 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore 
@@ -22,12 +24,36 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
-    int lock_priority;          /* acquire한 thread의 priority 중 가장 큰 값 */
+    int lock_priority;          /* 기다리는 thread의 priority 중 가장 큰 값,
+                                   없으면 -1 */
     struct list_elem elem;      /* list elem */
 
+    /* -lockstat profiling. */
+    struct lock_class *class;   /* Statistics, or a null pointer. */
+    uint64_t acquired_at;       /* Cycle count when last acquired. */
   };
 
-void lock_init (struct lock *);
+/* Profile of a class of locks, the locks initialized with the
+   same name. */
+struct lock_class
+  {
+    const char *name;                   /* Name of the lock variable. */
+    unsigned long long acquired;        /* Acquisitions. */
+    unsigned long long contended;       /* Acquisitions that waited. */
+    unsigned long long wait_cycles;     /* Total time waited. */
+    unsigned long long max_wait_cycles; /* Longest single wait... */
+    void *max_wait_site;                /* ...and where it was called. */
+    unsigned long long max_hold_cycles; /* Longest time held. */
+  };
+
+extern bool lock_stats_enabled;
+
+/* Maximum number of locks that a priority donation passes
+   through. */
+#define DONATE_DEPTH_MAX 8
+
+void lock_init_named (struct lock *, const char *name);
+#define lock_init(LOCK) lock_init_named (LOCK, #LOCK)
 void donate_priority (struct thread *); 
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
@@ -35,6 +61,7 @@ void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
 void release_all_locks(void);
+void lock_print_stats (void);
 
 /* Condition variable. */
 struct condition 
@@ -47,6 +74,35 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock. */
+struct rwlock
+  {
+    struct lock lock;           /* Held by the writer. */
+    unsigned readers;           /* Number of threads reading. */
+    bool writer_waiting;        /* Writer waiting for readers to leave? */
+    struct semaphore drained;   /* Upped when the last reader leaves. */
+  };
+
+void rw_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_write_held_by_current_thread (const struct rwlock *);
+
+/* Spinlock.  Busy-waits, with interrupts off, for a lock that
+   may be held by another CPU.  For short critical sections
+   only; a holder must not sleep. */
+struct spinlock
+  {
+    volatile uint32_t locked;   /* Nonzero while held. */
+    enum intr_level old_level;  /* Holder's interrupt level. */
+  };
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
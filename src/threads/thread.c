@@ -7,10 +7,12 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/mp.h"
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -30,12 +32,39 @@ void *malloc(size_t);
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Per-CPU run queue: processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running, with
+   one FIFO list per priority.  Bit P of `mask' is set exactly
+   when lists[P] is nonempty, so the highest ready priority is a
+   count-leading-zeros away.
+
+   A ready thread waits in the queue of its `cpu', the CPU that
+   last ran it, so that it tends to run where its cache lines
+   are.  A CPU runs the best thread in its own queue unless
+   another queue holds a higher priority, in which case it steals
+   from that queue instead; in particular, a CPU whose own queue
+   is empty steals.  Among queues tied for the highest priority it
+   picks the busiest.  Making a thread ready interrupts another
+   CPU that should run it; see ready_kick(). */
+struct runqueue
+  {
+    struct spinlock lock;               /* Protects the members below. */
+    struct list lists[PRI_MAX + 1];     /* One list per priority. */
+    uint32_t mask[(PRI_MAX + 32) / 32]; /* Nonempty lists. */
+    int cnt;                            /* Number of threads in lists. */
+  };
+
+static struct runqueue runqueues[CPU_MAX];
 
-/* Idle thread. */
-static struct thread *idle_thread;
+/* Number of threads taken from another CPU's run queue. */
+static long long steal_cnt;
+
+/* List of all processes.  Processes are added to this list
+   when they are first scheduled and removed when they exit. */
+static struct list all_list;
+
+/* MLFQS system load average. */
+static fixed_t load_avg;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -43,6 +72,8 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+static struct thread *running_thread (void);
+
 /* thread를 priority 순서 대로 list set시키기 위한 보조 함수 */
 bool 
 thread_set_priority_list (const struct list_elem* a_, const struct list_elem* b_,
@@ -55,26 +86,319 @@ thread_set_priority_list (const struct list_elem* a_, const struct list_elem* b_
   return a->priority > b->priority;
 }
 
+/* Records that T receives a donation of PRIORITY. */
+void
+thread_donation_add (struct thread *t, int priority) 
+{
+  ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+  ASSERT (t->donations[priority] < UINT8_MAX);
+
+  if (t->donations[priority]++ == 0)
+    t->donation_mask[priority / 32] |= 1u << (priority % 32);
+}
+
+/* Withdraws a donation of PRIORITY from T. */
+void
+thread_donation_remove (struct thread *t, int priority) 
+{
+  ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+  ASSERT (t->donations[priority] > 0);
+
+  if (--t->donations[priority] == 0)
+    t->donation_mask[priority / 32] &= ~(1u << (priority % 32));
+}
+
+/* Sets T's priority to the greater of its own priority and the
+   highest priority donated to it. */
 void 
-thread_reset_priority(struct thread* target_thread){
+thread_reset_priority (struct thread *t) 
+{
   enum intr_level old_level = intr_disable ();
+  int priority = t->original_priority;
+  int i;
+
+  for (i = sizeof t->donation_mask / sizeof *t->donation_mask - 1; i >= 0; i--)
+    if (t->donation_mask[i] != 0)
+      {
+        int donated = i * 32 + 31 - __builtin_clz (t->donation_mask[i]);
+        if (donated > priority)
+          priority = donated;
+        break;
+      }
+  thread_update_priority (t, priority);
+
+  intr_set_level (old_level);
+}
+
+/* Returns true if T is the idle thread of its CPU. */
+static inline bool
+is_idle (const struct thread *t)
+{
+  return t == cpus[t->cpu].idle_thread;
+}
+
+/* Adds T to the back of RQ's list for T's priority.  RQ must be
+   locked. */
+static void
+rq_push (struct runqueue *rq, struct thread *t)
+{
+  list_push_back (&rq->lists[t->priority], &t->elem);
+  rq->mask[t->priority / 32] |= 1u << (t->priority % 32);
+  rq->cnt++;
+}
+
+/* Removes T from RQ.  RQ must be locked. */
+static void
+rq_remove (struct runqueue *rq, struct thread *t)
+{
+  list_remove (&t->elem);
+  if (list_empty (&rq->lists[t->priority]))
+    rq->mask[t->priority / 32] &= ~(1u << (t->priority % 32));
+  rq->cnt--;
+}
+
+/* Returns the highest priority that has a thread in RQ, or -1 if
+   RQ is empty. */
+static int
+rq_max_priority (const struct runqueue *rq)
+{
+  int i;
+
+  for (i = sizeof rq->mask / sizeof *rq->mask - 1; i >= 0; i--)
+    if (rq->mask[i] != 0)
+      return i * 32 + 31 - __builtin_clz (rq->mask[i]);
+  return -1;
+}
+
+/* Removes and returns the first thread of the highest priority
+   in RQ, or a null pointer if RQ is empty. */
+static struct thread *
+rq_pop (struct runqueue *rq)
+{
+  struct thread *t = NULL;
+  int priority;
+
+  spinlock_acquire (&rq->lock);
+  priority = rq_max_priority (rq);
+  if (priority >= 0)
+    {
+      t = list_entry (list_front (&rq->lists[priority]), struct thread, elem);
+      rq_remove (rq, t);
+    }
+  spinlock_release (&rq->lock);
+  return t;
+}
+
+/* Adds T, which must be ready, to the run queue of the CPU that
+   last ran it. */
+static void
+ready_insert (struct thread *t)
+{
+  struct runqueue *rq = &runqueues[t->cpu];
 
-  if (list_empty(&target_thread->lock_list)) {
-    target_thread->priority = target_thread->original_priority;
-    intr_set_level (old_level);
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  spinlock_acquire (&rq->lock);
+  rq_push (rq, t);
+  spinlock_release (&rq->lock);
+}
+
+/* Removes ready thread T from its run queue. */
+static void
+ready_remove (struct thread *t)
+{
+  struct runqueue *rq = &runqueues[t->cpu];
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  spinlock_acquire (&rq->lock);
+  rq_remove (rq, t);
+  spinlock_release (&rq->lock);
+}
+
+/* Returns the highest priority that has a ready thread in CPU's
+   run queue, or -1 if no thread is ready there. */
+static int
+ready_max_priority (int cpu)
+{
+  return rq_max_priority (&runqueues[cpu]);
+}
+
+/* Returns the number of ready threads on all CPUs. */
+static int
+ready_cnt (void)
+{
+  int cnt = 0;
+  int i;
+
+  for (i = 0; i < CPU_MAX; i++)
+    cnt += runqueues[i].cnt;
+  return cnt;
+}
+
+/* Returns the highest priority that has a ready thread on any
+   CPU, or -1 if no thread is ready. */
+static int
+ready_max_priority_all (void)
+{
+  int max = -1;
+  int i;
+
+  for (i = 0; i < CPU_MAX; i++)
+    {
+      int priority = ready_max_priority (i);
+      if (priority > max)
+        max = priority;
+    }
+  return max;
+}
+
+/* Returns the run queue, other than CPU's, that CPU should take
+   its next thread from, or -1 if CPU should run its own best
+   thread.  That is the queue with the highest ready priority, if
+   it is higher than anything in CPU's own queue, and among
+   queues tied for it the busiest.  The queues are read without
+   locking, so the choice is only a hint. */
+static int
+ready_steal_from (int cpu)
+{
+  int best = -1;
+  int best_priority = ready_max_priority (cpu);
+  int i;
+
+  for (i = 0; i < CPU_MAX; i++)
+    {
+      int priority;
+
+      if (i == cpu || runqueues[i].cnt == 0)
+        continue;
+      priority = ready_max_priority (i);
+      if (priority > best_priority
+          || (best >= 0 && priority == best_priority
+              && runqueues[i].cnt > runqueues[best].cnt))
+        {
+          best = i;
+          best_priority = priority;
+        }
+    }
+  return best;
+}
+
+/* Returns the priority of the thread that cpus[CPU] is running,
+   or PRI_MIN - 1 if it is idle. */
+static int
+cpu_priority (int cpu)
+{
+  struct thread *cur = cpus[cpu].current;
+
+  return cur == NULL || is_idle (cur) ? PRI_MIN - 1 : cur->priority;
+}
+
+/* T has just been queued on cpus[T->cpu].  If another CPU is idle
+   or running something less important than T, sends it a
+   reschedule IPI, so that it takes T now instead of at its next
+   tick.  T's own CPU is preferred, to keep T near its cache;
+   otherwise the CPU running the lowest priority.  The CPU running
+   this code is left alone: its caller preempts it through
+   thread_preempt() if need be. */
+static void
+ready_kick (struct thread *t)
+{
+  int self = running_thread ()->cpu;
+  int target = -1;
+  int target_priority = t->priority;
+  int i;
+
+  if (cpu_started_cnt < 2)
     return;
-  }
 
-  struct lock *priority_lock = list_entry(list_front(&target_thread->lock_list), struct lock, elem);
-  
-  if (priority_lock->lock_priority > target_thread->original_priority){
-    target_thread->priority = priority_lock->lock_priority;
-  } else {
-    target_thread->priority = target_thread->original_priority;
-  }
+  if (t->cpu != self && cpus[t->cpu].started
+      && cpu_priority (t->cpu) < t->priority)
+    target = t->cpu;
+  else
+    for (i = 0; i < cpu_cnt; i++)
+      if (i != self && cpus[i].started
+          && cpu_priority (i) < target_priority)
+        {
+          target = i;
+          target_priority = cpu_priority (i);
+        }
+  if (target >= 0)
+    mp_reschedule (target);
+}
 
-  intr_set_level (old_level);
+/* Returns the number of CPUs that are running some thread other
+   than their idle thread. */
+static int
+running_cnt (void)
+{
+  int cnt = 0;
+  int i;
+
+  for (i = 0; i < cpu_cnt; i++)
+    if (cpus[i].started && cpus[i].current != NULL
+        && !is_idle (cpus[i].current))
+      cnt++;
+  return cnt;
+}
+
+/* Recomputes T's MLFQS priority from its recent_cpu and nice
+   values. */
+static void
+mlfqs_update_priority (struct thread *t)
+{
+  int priority = PRI_MAX - fp_to_int (t->recent_cpu / 4) - t->nice * 2;
 
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  thread_update_priority (t, priority);
+}
+
+/* Once-per-second MLFQS update: decays every thread's
+   recent_cpu by the load average, which is itself updated
+   first, and recomputes every thread's priority. */
+static void
+mlfqs_update_second (void)
+{
+  int ready_threads = ready_cnt () + running_cnt ();
+  fixed_t coefficient;
+  struct list_elem *e;
+
+  load_avg = fp_mul (fp_div (fp_from_int (59), fp_from_int (60)), load_avg)
+             + fp_from_int (ready_threads) / 60;
+  coefficient = fp_div (2 * load_avg, fp_add_int (2 * load_avg, 1));
+
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      if (is_idle (t))
+        continue;
+      t->recent_cpu = fp_add_int (fp_mul (coefficient, t->recent_cpu), t->nice);
+      mlfqs_update_priority (t);
+    }
+}
+
+/* Sets T's effective priority to PRIORITY.  A ready thread is
+   moved to the list for its new priority. */
+void
+thread_update_priority (struct thread *t, int priority)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  if (t->status == THREAD_READY && t->priority != priority)
+    {
+      ready_remove (t);
+      t->priority = priority;
+      ready_insert (t);
+    }
+  else
+    t->priority = priority;
+  intr_set_level (old_level);
 }
 
 /* Stack frame for kernel_thread(). */
@@ -92,7 +416,6 @@ static long long user_ticks;    /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
-static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
@@ -102,7 +425,7 @@ bool thread_mlfqs;
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
-static struct thread *running_thread (void);
+static void idle_loop (void) NO_RETURN;
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
@@ -112,18 +435,23 @@ void schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
 
 
-/* ready list에서의 thread가 현재 thread보다 높은 priority를 갖을 때 */
+/* ready list에서의 thread가 현재 thread보다 높은 priority를 갖을 때.
+   Any CPU's run queue counts, since next_thread_to_run() steals a
+   higher-priority thread from another CPU.  In an interrupt
+   handler the yield happens on return from the interrupt. */
 void thread_preempt(void)
 {
   enum intr_level old_level = intr_disable ();
-  if (list_empty(&ready_list)) return;
 
-  struct thread* curr_thread = thread_current();
-  struct thread* next_thread = list_entry(list_front(&ready_list), struct thread, elem);
-  
-  if (next_thread->priority > curr_thread->priority){
-    thread_yield();
-  }
+  struct thread *cur = thread_current ();
+
+  if (ready_max_priority_all () > cur->priority)
+    {
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        thread_yield ();
+    }
   intr_set_level (old_level);
 }
 
@@ -143,16 +471,27 @@ void thread_preempt(void)
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  for (i = 0; i < CPU_MAX; i++)
+    {
+      int j;
+
+      spinlock_init (&runqueues[i].lock);
+      for (j = 0; j <= PRI_MAX; j++)
+        list_init (&runqueues[i].lists[j]);
+    }
+  list_init (&all_list);
   
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
   init_thread (initial_thread, "main", PRI_DEFAULT);
   initial_thread->status = THREAD_RUNNING;
   initial_thread->tid = allocate_tid ();
+  cpus[0].current = initial_thread;
 
 }
 
@@ -169,19 +508,21 @@ thread_start (void)
   /* Start preemptive thread scheduling. */
   intr_enable ();
 
-  /* Wait for the idle thread to initialize idle_thread. */
+  /* Wait for the idle thread to initialize cpus[0].idle_thread. */
   sema_down (&idle_started);
 }
 
-/* Called by the timer interrupt handler at each timer tick.
-   Thus, this function runs in an external interrupt context. */
+/* Called by the timer interrupt handler at each timer tick: the
+   PIT's on the BSP, the local APIC timer's on an AP.  Thus, this
+   function runs in an external interrupt context. */
 void
 thread_tick (void) 
 {
   struct thread *t = thread_current ();
+  struct cpu *cpu = &cpus[t->cpu];
 
   /* Update statistics. */
-  if (t == idle_thread)
+  if (is_idle (t))
     idle_ticks++;
 #ifdef USERPROG
   else if (t->pagedir != NULL)
@@ -190,17 +531,55 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  /* MLFQS accounting.  Only the running thread's recent_cpu
+     changes between once-per-second updates, so only its
+     priority needs recomputing every time slice.  A thread that
+     gives up the CPU between slices is caught up in
+     schedule().  The once-per-second update is the BSP's job;
+     an AP counts slices in its own ticks. */
+  if (thread_mlfqs)
+    {
+      int64_t ticks = t->cpu == 0 ? timer_ticks () : cpu->ticks;
+
+      if (!is_idle (t))
+        t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+      if (t->cpu == 0 && ticks % TIMER_FREQ == 0)
+        mlfqs_update_second ();
+      else if (ticks % TIME_SLICE == 0 && !is_idle (t))
+        mlfqs_update_priority (t);
+      thread_preempt ();
+    }
+
   /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
+  if (++cpu->thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
 }
 
+/* Charges N timer ticks that passed without timer interrupts,
+   while the idle thread ran, to idle time.  See
+   timer_idle_exit(). */
+void
+thread_tick_idle (int n)
+{
+  idle_ticks += n;
+}
+
+/* Returns the number of threads that CPUs have taken from
+   another CPU's run queue. */
+long long
+thread_steal_cnt (void) 
+{
+  return steal_cnt;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) 
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  if (steal_cnt > 0)
+    printf ("Thread: %lld threads stolen from other CPUs\n", steal_cnt);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -221,6 +600,17 @@ thread_print_stats (void)
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
+{
+  return thread_create_on (running_thread ()->cpu, name, priority,
+                           function, aux);
+}
+
+/* Like thread_create(), but queues the new thread on cpus[CPU]
+   instead of on the creating thread's CPU.  Another CPU may still
+   steal it before CPU runs it. */
+tid_t
+thread_create_on (int cpu, const char *name, int priority,
+                  thread_func *function, void *aux) 
 {
   struct thread *t;
   struct kernel_thread_frame *kf;
@@ -229,6 +619,7 @@ thread_create (const char *name, int priority,
   tid_t tid;
 
   ASSERT (function != NULL);
+  ASSERT (cpu >= 0 && cpu < CPU_MAX);
 
   /* Allocate thread. */
   t = palloc_get_page (PAL_ZERO);
@@ -238,6 +629,7 @@ thread_create (const char *name, int priority,
   /* Initialize thread. */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
+  t->cpu = cpu;
 
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame (t, sizeof *kf);
@@ -296,7 +688,8 @@ thread_block (void)
    This function does not preempt the running thread.  This can
    be important: if the caller had disabled interrupts itself,
    it may expect that it can atomically unblock a thread and
-   update other data. */
+   update other data.  It may interrupt another CPU, though, to
+   have it run T. */
 void
 thread_unblock (struct thread *t) 
 {
@@ -307,8 +700,9 @@ thread_unblock (struct thread *t)
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
 
-  list_insert_ordered (&ready_list, &t->elem, thread_set_priority_list, NULL);
   t->status = THREAD_READY;
+  ready_insert (t);
+  ready_kick (t);
   intr_set_level (old_level);
 }
 
@@ -358,6 +752,7 @@ thread_exit (void)
   /* Just set our status to dying and schedule another process.
      We will be destroyed during the call to schedule_tail(). */
   intr_disable ();
+  list_remove (&thread_current ()->allelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -374,9 +769,9 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  if (curr != idle_thread)
-    list_insert_ordered (&ready_list, &curr->elem, thread_set_priority_list, NULL);
   curr->status = THREAD_READY;
+  if (!is_idle (curr))
+    ready_insert (curr);
   schedule ();
   intr_set_level (old_level);
 }
@@ -385,6 +780,9 @@ thread_yield (void)
 void
 thread_set_priority (int new_priority) 
 {
+  /* The MLFQS sets priorities itself. */
+  if (thread_mlfqs)
+    return;
 
   enum intr_level old_level = intr_disable ();
 
@@ -392,11 +790,11 @@ thread_set_priority (int new_priority)
   int curr_priority = curr_thread->priority;
   curr_thread->original_priority = new_priority;
 
-  /* ready list에서 priority 더 높은 thread 있으면 yield 시켜야함 */
-  if (curr_priority > new_priority){
-    thread_reset_priority(curr_thread);
+  /* 올릴 때도 donation을 고려해서 다시 계산하고,
+     ready list에서 priority 더 높은 thread 있으면 yield 시켜야함 */
+  thread_reset_priority(curr_thread);
+  if (curr_priority > curr_thread->priority)
     thread_preempt();
-  }
 
   intr_set_level (old_level);
 }
@@ -408,52 +806,77 @@ thread_get_priority (void)
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-  /* Not yet implemented. */
+  enum intr_level old_level = intr_disable ();
+  struct thread *cur = thread_current ();
+
+  ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+  cur->nice = nice;
+  mlfqs_update_priority (cur);
+  thread_preempt ();
+  intr_set_level (old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int result = fp_round (load_avg * 100);
+  intr_set_level (old_level);
+  return result;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int result = fp_round (thread_current ()->recent_cpu * 100);
+  intr_set_level (old_level);
+  return result;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
-   The idle thread is initially put on the ready list by
+   The BSP's idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
-   to it to enable thread_start() to continue, and immediately
-   blocks.  After that, the idle thread never appears in the
-   ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   point it initializes cpus[0].idle_thread, "up"s the semaphore
+   passed to it to enable thread_start() to continue, and
+   immediately blocks.  After that, the idle thread never appears
+   in the ready list.  It is returned by next_thread_to_run() as
+   a special case when there is no thread to run.
+
+   An AP's idle thread comes from thread_create_idle() instead
+   and starts in thread_start_ap(). */
 static void
 idle (void *idle_started_ UNUSED) 
 {
   struct semaphore *idle_started = idle_started_;
-  idle_thread = thread_current ();
+  struct thread *cur = thread_current ();
+
+  cpus[cur->cpu].idle_thread = cur;
   sema_up (idle_started);
+  idle_loop ();
+}
+
+/* Body of every CPU's idle thread. */
+static void
+idle_loop (void) 
+{
+  struct thread *cur = thread_current ();
 
   for (;;) 
     {
@@ -461,22 +884,46 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
-      /* Re-enable interrupts and wait for the next one.
-
-         The `sti' instruction disables interrupts until the
-         completion of the next instruction, so these two
-         instructions are executed atomically.  This atomicity is
-         important; otherwise, an interrupt could be handled
-         between re-enabling interrupts and waiting for the next
-         one to occur, wasting as much as one clock tick worth of
-         time.
+      /* Stop the periodic tick until there is timer work.  Only
+         the BSP ticks from the PIT. */
+      if (cur->cpu == 0)
+        timer_idle_enter ();
 
-         See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-         7.11.1 "HLT Instruction". */
-      asm volatile ("sti; hlt" : : : "memory");
+      /* Re-enable interrupts and wait for the next one. */
+      intr_halt ();
     }
 }
 
+/* Creates the idle thread for AP CPU and returns it.  It is
+   never put in a run queue: mp_start() starts the AP on its
+   stack, and the AP turns into it in thread_start_ap(). */
+struct thread *
+thread_create_idle (int cpu) 
+{
+  struct thread *t = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+
+  init_thread (t, "idle", PRI_MIN);
+  t->tid = allocate_tid ();
+  t->cpu = cpu;
+  return t;
+}
+
+/* Called by mp_ap_main(), with interrupts off, on the stack of
+   the thread from thread_create_idle(): makes that thread this
+   AP's running idle thread. */
+void
+thread_start_ap (void) 
+{
+  struct thread *t = running_thread ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (t));
+
+  t->status = THREAD_RUNNING;
+  cpus[t->cpu].idle_thread = cpus[t->cpu].current = t;
+  idle_loop ();
+}
+
 /* Function used as the basis for a kernel thread. */
 static void
 kernel_thread (thread_func *function, void *aux) 
@@ -514,10 +961,26 @@ is_thread (struct thread *t)
 static void
 init_thread (struct thread *t, const char *name, int priority)
 {
+  struct thread *parent = running_thread ();
+  enum intr_level old_level;
+  int nice = NICE_DEFAULT;
+  fixed_t recent_cpu = 0;
+  int cpu = 0;
+
   ASSERT (t != NULL);
   ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
   ASSERT (name != NULL);
 
+  /* Threads inherit nice and recent_cpu from their parent.  The
+     initial thread, which is initializing itself, starts from
+     zero. */
+  if (parent != t && is_thread (parent))
+    {
+      nice = parent->nice;
+      recent_cpu = parent->recent_cpu;
+      cpu = parent->cpu;
+    }
+
   memset (t, 0, sizeof *t);
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
@@ -531,14 +994,25 @@ init_thread (struct thread *t, const char *name, int priority)
   t->original_priority = priority;
 #ifdef VM
   /* mmap 초기화 */
-  list_init(&t->mmap_list);
+  list_init(&t->vma_list);
   t->mapid = 0;
 #endif
+#ifdef USERPROG
   /* project 2를 위한 것들 */
   sema_init(&t->load_sema, 0);
   list_init (&t->fd_list);
   list_init (&t->child_list);
   t->fd_count = 2;
+#endif
+  t->nice = nice;
+  t->recent_cpu = recent_cpu;
+  t->cpu = cpu;
+  if (thread_mlfqs)
+    mlfqs_update_priority (t);
+
+  old_level = intr_disable ();
+  list_push_back (&all_list, &t->allelem);
+  intr_set_level (old_level);
 }
 
 /* Allocates a SIZE-byte frame at the top of thread T's stack and
@@ -558,18 +1032,30 @@ alloc_frame (struct thread *t, size_t size)
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   this CPU's idle thread. */
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list)) {
-    return idle_thread;
-  } else {
-    /* list(readylist)에서 thread를 빼기 전에 정렬을 한다 */
-    list_sort(&ready_list, thread_set_priority_list, NULL);
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+  int cpu = running_thread ()->cpu;
+  int victim = ready_steal_from (cpu);
+  struct thread *t = NULL;
 
-  }
+  /* 다른 CPU의 queue에 더 높은 priority가 있으면 그것부터 */
+  if (victim >= 0)
+    {
+      t = rq_pop (&runqueues[victim]);
+      if (t != NULL)
+        steal_cnt++;
+    }
+  /* 가장 높은 priority의 list 맨 앞 thread */
+  if (t == NULL)
+    t = rq_pop (&runqueues[cpu]);
+  if (t == NULL)
+    return cpus[cpu].idle_thread;
+
+  /* 이제 이 CPU에서 돈다 */
+  t->cpu = cpu;
+  return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -597,9 +1083,10 @@ schedule_tail (struct thread *prev)
 
   /* Mark us as running. */
   curr->status = THREAD_RUNNING;
+  cpus[curr->cpu].current = curr;
 
   /* Start new time slice. */
-  thread_ticks = 0;
+  cpus[curr->cpu].thread_ticks = 0;
 
 #ifdef USERPROG
   /* Activate the new address space. */
@@ -629,13 +1116,24 @@ static void
 schedule (void) 
 {
   struct thread *curr = running_thread ();
-  struct thread *next = next_thread_to_run ();
+  struct thread *next;
   struct thread *prev = NULL;
 
   ASSERT (intr_get_level () == INTR_OFF);
   ASSERT (curr->status != THREAD_RUNNING);
+
+  /* The outgoing thread's recent_cpu may have grown since its
+     priority was last computed, if it blocked or yielded before
+     the next time-slice boundary. */
+  if (thread_mlfqs && !is_idle (curr) && curr->status != THREAD_DYING)
+    mlfqs_update_priority (curr);
+
+  next = next_thread_to_run ();
   ASSERT (is_thread (next));
 
+  if (curr->cpu == 0 && is_idle (curr))
+    timer_idle_exit ();
+
   if (curr != next)
     prev = switch_threads (curr, next);
   schedule_tail (prev); 
@@ -5,6 +5,7 @@
 #include <list.h>
 #include <hash.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/synch.h"
 
 /* States in a thread's life cycle. */
@@ -29,6 +30,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the MLFQS. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_DEFAULT 0                  /* Default. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* File descriptor of thread. */
 struct thread_fd
   {
@@ -124,14 +130,20 @@ struct thread
     enum thread_status child_status;
     struct semaphore load_sema;
     struct thread *parent;
+    struct ring_sq *ring_sq;            /* Registered submission queue. */
+    struct ring_cq *ring_cq;            /* Registered completion queue. */
 #endif
 #ifdef VM
     struct hash page_table;             /* Page table. */
     void *esp;                          /* Stack Pointer. */
 
     /* start process에서 초기화 */
-    struct list mmap_list;              /* mmap table */
+    struct list vma_list;               /* 영역 (segment, mmap), start 순 */
     int mapid;                          /* mapid */
+
+    /* fault-around 순차 접근 감지 */
+    void *fault_next;                   /* 직전 window 바로 다음 page */
+    int fault_window;                   /* 직전 window 크기 (page) */
 #endif
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
@@ -146,6 +158,20 @@ struct thread
     /* 여러 개의 lock을 들고 있는 경우 */
     struct list lock_list;
 
+    /* donation받은 priority별 개수.  bit P of donation_mask is
+       set exactly when donations[P] is nonzero. */
+    uint8_t donations[PRI_MAX + 1];
+    uint32_t donation_mask[(PRI_MAX + 32) / 32];
+
+    /* Scheduling. */
+    int cpu;                            /* Index in cpus[] of the CPU that
+                                           last ran this thread. */
+
+    /* MLFQS. */
+    int nice;                           /* Niceness, NICE_MIN to NICE_MAX. */
+    fixed_t recent_cpu;                 /* Recently used CPU time. */
+    struct list_elem allelem;           /* List element for all threads list. */
+
   };
 
 /* If false (default), use round-robin scheduler.
@@ -155,15 +181,24 @@ extern bool thread_mlfqs;
 
 void thread_preempt(void);
 void thread_reset_priority(struct thread* );
+void thread_donation_add (struct thread *, int priority);
+void thread_donation_remove (struct thread *, int priority);
+void thread_update_priority (struct thread *, int priority);
 bool thread_set_priority_list (const struct list_elem*, const struct list_elem*, void *);
 void thread_init (void);
 void thread_start (void);
+struct thread *thread_create_idle (int cpu);
+void thread_start_ap (void) NO_RETURN;
 
 void thread_tick (void);
+void thread_tick_idle (int);
+long long thread_steal_cnt (void);
 void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+tid_t thread_create_on (int cpu, const char *name, int priority,
+                        thread_func *, void *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -17,6 +17,35 @@
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* Exception fixup table.
+
+   Kernel code that touches user memory does so only through the
+   handful of instructions below, each of which has an entry in
+   this table giving the address to resume at if that instruction
+   faults on an invalid user address.  page_fault() looks up the
+   faulting EIP here and, on a match, redirects execution to the
+   fixup instead of treating the fault as fatal.  This lets a bulk
+   copy touch each user page exactly once, at full speed, without
+   validating it beforehand.
+
+   The linker gathers the entries into the __ex_table section,
+   bounded by _start_ex_table and _end_ex_table (see
+   threads/kernel.lds.S). */
+struct exception_fixup
+  {
+    uintptr_t insn;             /* Address of faulting instruction. */
+    uintptr_t fixup;            /* Address to continue at instead. */
+  };
+
+/* Emits an exception table entry for the instruction at label
+   INSN, continuing at label FIXUP. */
+#define EX_TABLE(INSN, FIXUP)                   \
+        ".pushsection __ex_table, \"a\"\n"       \
+        ".long " INSN ", " FIXUP "\n"            \
+        ".popsection\n"
+
+static uintptr_t search_exception_table (uintptr_t eip);
+
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 /* Help functions. */
@@ -173,7 +202,7 @@ page_fault (struct intr_frame *f)
     if(page)
     {
       page->busy = true;
-      success = page_load(page);
+      success = page_load(page, write);
       page->busy = false;
       if(success) return;
     }
@@ -187,7 +216,29 @@ page_fault (struct intr_frame *f)
       }
     }
   }
+  else if(write && is_user_vaddr(fault_addr))
+  { // fork로 공유 중인 page에 씀: copy-on-write
+    struct page *page = ptable_lookup(fault_addr);
+    if(page && page->writable)
+    {
+      page->busy = true;
+      success = frame_cow(page);
+      page->busy = false;
+      if(success) return;
+    }
+  }
 #endif
+  if(!user && is_user_vaddr(fault_addr))
+  {
+    /* A copy to or from user memory hit an invalid address.
+       Resume at its fixup, which reports the failure. */
+    uintptr_t fixup = search_exception_table((uintptr_t) f->eip);
+    if(fixup != 0)
+    {
+      f->eip = (void (*) (void)) fixup;
+      return;
+    }
+  }
   if(not_present || write || user) system_exit(-1);
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
@@ -214,3 +265,113 @@ bring_esp_from_thread_struct(bool user, bool not_present, struct intr_frame *f)
   }
 }
 #endif
+
+/* Returns the fixup address for a fault at EIP, or 0 if EIP is
+   not one of the user access instructions. */
+static uintptr_t
+search_exception_table (uintptr_t eip)
+{
+  extern const struct exception_fixup _start_ex_table[], _end_ex_table[];
+  const struct exception_fixup *e;
+
+  for (e = _start_ex_table; e < _end_ex_table; e++)
+    if (e->insn == eip)
+      return e->fixup;
+  return 0;
+}
+
+/* Returns true if the SIZE bytes starting at UADDR lie entirely
+   below PHYS_BASE.  The pages themselves may still be unmapped;
+   the copy routines catch that when they touch them. */
+static bool
+user_range_ok (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, either of which may be a
+   user address, a word at a time and then a byte at a time.
+   Returns the number of bytes left uncopied, which is nonzero
+   only if a user address faulted. */
+static size_t
+copy_user (void *dst, const void *src, size_t size)
+{
+  size_t words = size / sizeof (uint32_t);
+  size_t bytes = size % sizeof (uint32_t);
+
+  asm volatile ("1: rep movsl\n"
+                "   movl %[bytes], %%ecx\n"
+                "2: rep movsb\n"
+                "   jmp 4f\n"
+                "3: leal (%[bytes], %%ecx, 4), %%ecx\n"
+                "4:\n"
+                EX_TABLE ("1b", "3b")
+                EX_TABLE ("2b", "4b")
+                : "+c" (words), "+D" (dst), "+S" (src)
+                : [bytes] "r" (bytes)
+                : "memory");
+  return words;
+}
+
+/* Reads a byte at user virtual address UADDR, which must be below
+   PHYS_BASE.  Returns the byte value if successful, -1 if a
+   segfault occurred. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int result;
+  asm volatile ("1: movzbl %1, %0\n"
+                "   jmp 3f\n"
+                "2: movl $-1, %0\n"
+                "3:\n"
+                EX_TABLE ("1b", "2b")
+                : "=&r" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if any part of the
+   source is not valid user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return user_range_ok (usrc, size) && copy_user (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if any part of the
+   destination is not valid, writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return user_range_ok (udst, size) && copy_user (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, which has room for SIZE bytes including the terminator.
+   Returns the length of the string if it fit, SIZE if it had to
+   be truncated (DST is still null-terminated), or -1 if the
+   string is not valid user memory. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  const uint8_t *p = (const uint8_t *) usrc;
+  size_t length;
+
+  ASSERT (size > 0);
+  for (length = 0; length < size; length++, p++)
+    {
+      int c;
+      if (!is_user_vaddr (p))
+        return -1;
+      c = get_user (p);
+      if (c < 0)
+        return -1;
+      dst[length] = c;
+      if (c == '\0')
+        return length;
+    }
+  dst[size - 1] = '\0';
+  return size;
+}
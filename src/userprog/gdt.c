@@ -35,22 +35,34 @@ static uint64_t make_gdtr_operand (uint16_t limit, void *base);
 void
 gdt_init (void)
 {
-  uint64_t gdtr_operand;
+  int i;
 
-  /* Initialize GDT. */
+  /* Initialize GDT.  Each CPU has its own TSS. */
   gdt[SEL_NULL / sizeof *gdt] = 0;
   gdt[SEL_KCSEG / sizeof *gdt] = make_code_desc (0);
   gdt[SEL_KDSEG / sizeof *gdt] = make_data_desc (0);
   gdt[SEL_UCSEG / sizeof *gdt] = make_code_desc (3);
   gdt[SEL_UDSEG / sizeof *gdt] = make_data_desc (3);
-  gdt[SEL_TSS / sizeof *gdt] = make_tss_desc (tss_get ());
+  for (i = 0; i < CPU_MAX; i++)
+    gdt[SEL_TSS_CPU (i) / sizeof *gdt] = make_tss_desc (tss_get (i));
+
+  gdt_load ();
+}
+
+/* Loads the GDT, and this CPU's TSS, into the running CPU.
+   Called by gdt_init() on the BSP and by each AP as it starts. */
+void
+gdt_load (void) 
+{
+  uint64_t gdtr_operand;
+  int cpu = cpu_current () - cpus;
 
   /* Load GDTR, TR.  See [IA32-v3a] 2.4.1 "Global Descriptor
      Table Register (GDTR)", 2.4.4 "Task Register (TR)", and
      6.2.4 "Task Register".  */
   gdtr_operand = make_gdtr_operand (sizeof gdt - 1, gdt);
   asm volatile ("lgdt %0" : : "m" (gdtr_operand));
-  asm volatile ("ltr %w0" : : "r" (SEL_TSS));
+  asm volatile ("ltr %w0" : : "r" (SEL_TSS_CPU (cpu)));
 }
 
 /* System segment or code/data segment? */
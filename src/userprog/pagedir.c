@@ -156,6 +156,24 @@ pagedir_clear_page (uint32_t *pd, void *upage)
     }
 }
 
+/* Makes the mapping for user virtual page VPAGE in PD writable or
+   read-only according to WRITABLE.  The other bits in the page
+   table entry, including accessed and dirty, are preserved.
+   VPAGE need not be mapped. */
+void
+pagedir_set_writable (uint32_t *pd, const void *vpage, bool writable) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  if (pte != NULL && (*pte & PTE_P) != 0) 
+    {
+      if (writable)
+        *pte |= PTE_W;
+      else 
+        *pte &= ~(uint32_t) PTE_W;
+      invalidate_pagedir (pd);
+    }
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
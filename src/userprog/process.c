@@ -19,6 +19,7 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 
 #ifdef VM
 #include "vm/frame.h"
@@ -26,6 +27,10 @@
 #endif
 
 static thread_func start_process NO_RETURN;
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+static bool fork_copy (struct thread *parent);
+#endif
 static bool load (const char *cmdline, void (**eip) (void), void **esp, char** token_ptr);
 void free(void *ptr);
 void *malloc(size_t);
@@ -54,9 +59,6 @@ void close_all_files(void)
       free(t_fd);
     }
   }
-  filesys_acquire();
-  file_close(cur->executable);
-  filesys_release();
 }
 
 int wait_child(tid_t child_tid)
@@ -218,6 +220,108 @@ start_process (void *f_name)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Creates a child process that is a copy of the current one and
+   resumes user mode from the parent's interrupt frame IF_ with
+   a return value of 0.  The parent's writable pages are shared
+   with the child copy-on-write.  Returns the child's thread id,
+   or TID_ERROR if the thread cannot be created.  As with
+   process_execute(), the caller waits on load_sema for the
+   child to finish copying. */
+tid_t
+process_fork (struct intr_frame *if_)
+{
+  struct thread *cur = thread_current ();
+  tid_t tid;
+
+  /* 자식이 load_sema를 올릴 때까지 부모는 syscall 안에서 기다리므로
+     IF_는 그동안 유효하다. */
+  tid = thread_create (cur->name, PRI_DEFAULT, start_fork, if_);
+  if (tid == TID_ERROR)
+  {
+    cur->child_status = LOAD_FAILED;
+    sema_up(&cur->load_sema);
+  }
+  return tid;
+}
+
+/* A thread function that copies the parent process into the new
+   thread and makes it return from fork(). */
+static void
+start_fork (void *parent_if)
+{
+  struct thread *cur = thread_current ();
+  struct intr_frame if_ = *(struct intr_frame *) parent_if;
+
+  ptable_init(&cur->page_table);
+  if (!fork_copy (cur->parent))
+  {
+    cur->parent->child_status = LOAD_FAILED;
+    sema_up(&cur->parent->load_sema);
+    system_exit(-1);
+  }
+  cur->parent->child_status = LOAD_DONE;
+  sema_up(&cur->parent->load_sema);
+
+  /* 자식에서 fork()는 0을 return한다 */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* PARENT의 page directory, executable, file descriptor, page table,
+   mmap을 현재 thread로 복제한다.  실패하면 복제한 것까지는
+   process_exit()가 정리한다. */
+static bool
+fork_copy (struct thread *parent)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  cur->pagedir = pagedir_create ();
+  if (cur->pagedir == NULL)
+    return false;
+  if (!pagedir_set_page (cur->pagedir, (void *) CLOCK_PAGE,
+                         timer_clock_page (), false))
+    return false;
+  process_activate ();
+
+  filesys_acquire();
+  cur->executable = file_reopen(parent->executable);
+  if (cur->executable != NULL)
+    file_deny_write(cur->executable);
+  filesys_release();
+  if (cur->executable == NULL)
+    return false;
+
+  /* fd 번호와 file 위치는 그대로 */
+  for(e=list_begin(&parent->fd_list); e!=list_end(&parent->fd_list); e=list_next(e))
+  {
+    struct thread_fd *p_fd = list_entry(e, struct thread_fd, elem);
+    struct thread_fd *t_fd = malloc(sizeof *t_fd);
+    if(!t_fd) return false;
+    filesys_acquire();
+    t_fd->file = file_reopen(p_fd->file);
+    if(t_fd->file)
+      file_seek(t_fd->file, file_tell(p_fd->file));
+    filesys_release();
+    if(!t_fd->file)
+    {
+      free(t_fd);
+      return false;
+    }
+    t_fd->fd = p_fd->fd;
+    list_push_back(&cur->fd_list, &t_fd->elem);
+  }
+  cur->fd_count = parent->fd_count;
+
+  if (!ptable_fork (parent))
+    return false;
+  cur->mapid = parent->mapid;
+  return true;
+}
+#endif
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -246,44 +350,13 @@ mmap_clear()
 #endif
   struct thread *curr = thread_current();
   struct list_elem *e;
-  struct page *page;
-  struct file *file = NULL;
-  if(list_empty(&curr->mmap_list)) return;
-  int prev_mapid = 0;
-  for(e=list_front(&curr->mmap_list);e!=list_end(&curr->mmap_list);)
+  for(e=list_begin(&curr->vma_list); e!=list_end(&curr->vma_list);)
   {
-    page = list_entry(e, struct page, list_elem);
+    struct vma *vma = list_entry(e, struct vma, elem);
     e = list_next(e);
-    list_remove(&page->list_elem);
-    if(pagedir_is_dirty(curr->pagedir, page->upage))
-    {
-      filesys_acquire();
-      file_write_at(page->file, page->upage, page->read_bytes, page->offset);
-      filesys_release();
-    }
-    frame_free(pagedir_get_page(curr->pagedir, page->upage));
-    pagedir_clear_page(curr->pagedir, page->upage);
-    hash_delete(&curr->page_table, &page->hash_elem);
-    if(page->mapid != prev_mapid)
-    {
-      if(file)
-      {
-        filesys_acquire();
-        file_close(file);
-        filesys_release();
-      }
-      prev_mapid = page->mapid;
-      file = page->file;
-    }
-    free(page);
+    if(vma->mapid != MAP_FAILED)
+      vma_destroy(vma);
   }
-  if(file)
-  {
-    filesys_acquire();
-    file_close(file);
-    filesys_release();
-  }
-  return;
 }
 #endif
 
@@ -302,6 +375,11 @@ process_exit (void)
   mmap_clear();
   ptable_clear();
 #endif
+  /* text table이 executable의 inode로 frame을 찾으므로, page를 다
+     정리한 뒤에 닫는다. */
+  filesys_acquire();
+  file_close(cur->executable);
+  filesys_release();
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -316,6 +394,8 @@ process_exit (void)
          that's been freed (and cleared). */
       cur->pagedir = NULL;
       pagedir_activate (NULL);
+      /* 공유하는 clock page는 free되면 안 된다 */
+      pagedir_clear_page (pd, (void *) CLOCK_PAGE);
       pagedir_destroy (pd);
     }
 }
@@ -427,6 +507,10 @@ load (const char *file_name, void (**eip) (void), void **esp, char **token_ptr)
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
     goto done;
+  /* clock page는 모든 process가 read-only로 공유 */
+  if (!pagedir_set_page (t->pagedir, (void *) CLOCK_PAGE,
+                         timer_clock_page (), false))
+    goto done;
   process_activate ();
   /* Open executable file. */
   file = filesys_open (file_name);
@@ -686,6 +770,11 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  /* 영역만 등록하고 page는 fault가 날 때 만든다 */
+  return vma_add (file, ofs, upage, read_bytes + zero_bytes, read_bytes,
+                  writable, MAP_FAILED);
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -694,13 +783,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
          and zero the final PAGE_ZERO_BYTES bytes. */
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
-#ifdef VM
-      struct page *page;
-      if((page=page_create(file, ofs, upage, page_read_bytes, writable)) == NULL)
-        return false;
-      if(!ptable_insert(page))
-        return false;
-#else
       uint8_t *kpage = palloc_get_page(PAL_USER);
       if(!kpage) return false;
       if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
@@ -714,16 +796,13 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false;
         }
-#endif
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
       upage += PGSIZE;
-#ifdef VM
-      ofs += PGSIZE;
-#endif
     }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -743,6 +822,8 @@ setup_stack (void **esp)
   page->swaped = false;
   page->mapid = -1;
   page->busy = false;
+  page->zswap = NULL;
+  page->cow_next = NULL;
   kpage = frame_alloc(PAL_USER | PAL_ZERO, page);
 #else
   kpage = palloc_get_page(PAL_USER | PAL_ZERO);
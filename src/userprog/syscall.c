@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include <user/syscall.h>
 #include "threads/interrupt.h"
@@ -7,8 +8,11 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/init.h"
+#include "threads/palloc.h"
+#include "userprog/exception.h"
 #include "userprog/process.h"
 #include "devices/input.h"
+#include "devices/timer.h"
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "filesys/off_t.h"
@@ -32,9 +36,15 @@ static int system_write(int fd, const void* buffer, unsigned size);
 static void system_seek(int fd, unsigned position);
 static unsigned system_tell(int fd);
 static void system_close(int fd);
+static int system_copy_range(int in_fd, int out_fd, unsigned length);
+static bool system_ring_setup(struct ring_sq *sq, struct ring_cq *cq);
+static int system_ring_enter(unsigned to_submit);
+static bool system_sysstat(int number, struct sysstat *ustat);
+static int system_clock(struct timespec *uts);
 #ifdef VM
 static int system_mmap (int fd, void *addr);
 static void system_munmap (int mapid);
+static pid_t system_fork (void);
 #endif
 
 //#define DEBUG
@@ -45,6 +55,11 @@ static void remove_file(int fd);
 
 static struct lock file_lock;
 
+/* Size of the kernel buffer that file name arguments are copied
+   into.  Names that do not fit are too long for the file system
+   anyway. */
+#define NAME_BUF_SIZE 64
+
 void
 filesys_acquire(void)
 {
@@ -56,15 +71,256 @@ filesys_release(void)
 	lock_release(&file_lock);
 }
 
+/* Copies ARGC 32-bit arguments, which follow the system call
+   number at ESP, into ARGS.  Kills the process if they are not
+   valid user memory. */
 static inline void
 get_arguments(int32_t* esp, int32_t* args, unsigned int argc)
 {
-	while(argc--)
+	if(!copy_from_user(args, esp + 1, argc * sizeof *args)) system_exit(-1);
+}
+
+/* Copies the file name at user address UNAME into NAME, which
+   has room for NAME_BUF_SIZE bytes.  Kills the process if UNAME
+   is not a valid string.  Returns false if the name is too long
+   to be a valid file name, true otherwise. */
+static bool
+get_file_name(char *name, const char *uname)
+{
+	int length = strncpy_from_user(name, uname, NAME_BUF_SIZE);
+	if(length < 0) system_exit(-1);
+	return length < NAME_BUF_SIZE;
+}
+
+/* System call dispatch.  Each handler receives the call's
+   arguments, already copied out of the user stack, and returns
+   the value for the caller's eax. */
+typedef int32_t syscall_func (const int32_t *args);
+
+struct syscall_desc
+  {
+    syscall_func *handler;      /* NULL if not implemented. */
+    unsigned argc;              /* Number of 32-bit arguments. */
+    const char *name;           /* Name for statistics. */
+  };
+
+static int32_t
+sys_halt (const int32_t *args UNUSED)
+{
+	system_halt();
+	return 0;
+}
+
+static int32_t
+sys_exit (const int32_t *args)
+{
+	system_exit(args[0]);
+	return 0;
+}
+
+static int32_t
+sys_exec (const int32_t *args)
+{
+	return system_exec((const char *)args[0]);
+}
+
+static int32_t
+sys_wait (const int32_t *args)
+{
+	return system_wait((pid_t)args[0]);
+}
+
+static int32_t
+sys_create (const int32_t *args)
+{
+	return system_create((const char*)args[0], (unsigned)args[1]);
+}
+
+static int32_t
+sys_remove (const int32_t *args)
+{
+	return system_remove((const char*)args[0]);
+}
+
+static int32_t
+sys_open (const int32_t *args)
+{
+	return system_open((const char*)args[0]);
+}
+
+static int32_t
+sys_filesize (const int32_t *args)
+{
+	return system_filesize((int)args[0]);
+}
+
+static int32_t
+sys_read (const int32_t *args)
+{
+	return system_read((int)args[0], (void*)args[1], (unsigned)args[2]);
+}
+
+static int32_t
+sys_write (const int32_t *args)
+{
+	return system_write((int)args[0], (const void*)args[1], (unsigned)args[2]);
+}
+
+static int32_t
+sys_seek (const int32_t *args)
+{
+	system_seek((int)args[0], (unsigned)args[1]);
+	return 0;
+}
+
+static int32_t
+sys_tell (const int32_t *args)
+{
+	return system_tell((int)args[0]);
+}
+
+static int32_t
+sys_close (const int32_t *args)
+{
+	system_close((int)args[0]);
+	return 0;
+}
+
+#ifdef VM
+static int32_t
+sys_mmap (const int32_t *args)
+{
+	return system_mmap((int) args[0], (void *) args[1]);
+}
+
+static int32_t
+sys_munmap (const int32_t *args)
+{
+	system_munmap((int) args[0]);
+	return 0;
+}
+#endif
+
+static int32_t
+sys_copy_range (const int32_t *args)
+{
+	return system_copy_range((int)args[0], (int)args[1], (unsigned)args[2]);
+}
+
+static int32_t
+sys_ring_setup (const int32_t *args)
+{
+	return system_ring_setup((struct ring_sq *)args[0], (struct ring_cq *)args[1]);
+}
+
+static int32_t
+sys_ring_enter (const int32_t *args)
+{
+	return system_ring_enter((unsigned)args[0]);
+}
+
+static int32_t
+sys_sysstat (const int32_t *args)
+{
+	return system_sysstat((int)args[0], (struct sysstat *)args[1]);
+}
+
+static int32_t
+sys_clock (const int32_t *args)
+{
+	return system_clock((struct timespec *)args[0]);
+}
+
+#ifdef VM
+static int32_t
+sys_fork (const int32_t *args UNUSED)
+{
+	return system_fork();
+}
+#endif
+
+static const struct syscall_desc syscall_table[SYS_CNT] =
+  {
+    [SYS_HALT] = {sys_halt, 0, "halt"},
+    [SYS_EXIT] = {sys_exit, 1, "exit"},
+    [SYS_EXEC] = {sys_exec, 1, "exec"},
+    [SYS_WAIT] = {sys_wait, 1, "wait"},
+    [SYS_CREATE] = {sys_create, 2, "create"},
+    [SYS_REMOVE] = {sys_remove, 1, "remove"},
+    [SYS_OPEN] = {sys_open, 1, "open"},
+    [SYS_FILESIZE] = {sys_filesize, 1, "filesize"},
+    [SYS_READ] = {sys_read, 3, "read"},
+    [SYS_WRITE] = {sys_write, 3, "write"},
+    [SYS_SEEK] = {sys_seek, 2, "seek"},
+    [SYS_TELL] = {sys_tell, 1, "tell"},
+    [SYS_CLOSE] = {sys_close, 1, "close"},
+#ifdef VM
+    [SYS_MMAP] = {sys_mmap, 2, "mmap"},
+    [SYS_MUNMAP] = {sys_munmap, 1, "munmap"},
+#endif
+    [SYS_COPY_RANGE] = {sys_copy_range, 3, "copy_range"},
+    [SYS_RING_SETUP] = {sys_ring_setup, 2, "ring_setup"},
+    [SYS_RING_ENTER] = {sys_ring_enter, 1, "ring_enter"},
+    [SYS_SYSSTAT] = {sys_sysstat, 2, "sysstat"},
+    [SYS_CLOCK] = {sys_clock, 1, "clock"},
+#ifdef VM
+    [SYS_FORK] = {sys_fork, 0, "fork"},
+#endif
+  };
+
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+#define SYSCALL_MAX_ARGS 3
+
+/* Per-call counts and latencies, indexed by system call number.
+   The name field is filled in only when a copy is handed out. */
+static struct sysstat syscall_stats[SYSCALL_CNT];
+
+/* Charges CYCLES spent in system call NUMBER to its latency
+   histogram. */
+static void
+syscall_account (int number, uint64_t cycles)
+{
+	struct sysstat *s = &syscall_stats[number];
+	unsigned bucket = 0;
+	enum intr_level old_level;
+	while(bucket < SYSSTAT_BUCKETS - 1 && cycles >> (bucket + 1) != 0)
+		bucket++;
+	old_level = intr_disable();
+	s->cycles += cycles;
+	s->hist[bucket]++;
+	intr_set_level(old_level);
+}
+
+/* Returns an upper bound, in cycles, on the latency of the
+   fraction PERCENT of S's calls that were fastest. */
+static uint64_t
+syscall_percentile (const struct sysstat *s, unsigned percent)
+{
+	uint64_t total = 0, seen = 0;
+	unsigned i;
+	for(i = 0; i < SYSSTAT_BUCKETS; i++)
+		total += s->hist[i];
+	for(i = 0; i < SYSSTAT_BUCKETS - 1; i++)
+	{
+		seen += s->hist[i];
+		if(seen * 100 >= total * percent) break;
+	}
+	return ((uint64_t) 2 << i) - 1;
+}
+
+/* Prints system call statistics. */
+void
+syscall_print_stats (void)
+{
+	unsigned i;
+	for(i = 0; i < SYSCALL_CNT; i++)
 	{
-		if(!is_user_vaddr((void *)esp)) system_exit(-1);
-  	*(args++) = *(++esp);
+		const struct sysstat *s = &syscall_stats[i];
+		if(s->count == 0) continue;
+		printf("Syscall %s: %llu calls, %llu cycles avg, p50 < %llu, p99 < %llu\n",
+		       syscall_table[i].name, s->count, s->cycles / s->count,
+		       syscall_percentile(s, 50), syscall_percentile(s, 99));
 	}
-	if(!is_user_vaddr((void *)esp)) system_exit(-1);
 }
 
 void
@@ -75,125 +331,33 @@ syscall_init (void)
 }
 
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+syscall_handler (struct intr_frame *f) 
 {
 #ifdef DEBUG
 	printf("syscall 진입\n");
 #endif
-  int32_t args[3];
-  unsigned int argc;
-  if(!is_user_vaddr(f->esp)) system_exit(-1);
+  int32_t args[SYSCALL_MAX_ARGS];
+  const struct syscall_desc *desc;
+  enum intr_level old_level;
+  uint64_t start;
+  int number;
 #ifdef VM
   thread_current()->esp = f->esp;
 #endif
-  switch(*(int*)f->esp)
-  {
-  	case SYS_HALT:
-  	{
-  		system_halt();
-  		break;
-  	}
-  	case SYS_EXIT:
-  	{		
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		system_exit(args[0]);
-  		break;
-  	}
-  	case SYS_EXEC:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_exec((const char *)args[0]);
-  		break;
-  	}
-  	case SYS_WAIT:
-  	{		
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_wait((pid_t)args[0]);
-  		break;
-  	}
-  	case SYS_CREATE:
-  	{
-  		argc = 2;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_create((const char*)args[0], (unsigned)args[1]);
-  		break;
-  	}
-  	case SYS_REMOVE:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_remove((const char*)args[0]);
-  		break;
-  	}
-  	case SYS_OPEN:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_open((const char*)args[0]);
-  		break;
-  	}
-  	case SYS_FILESIZE:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-      f->eax = system_filesize((int)args[0]);
-      break;
-  	}
-  	case SYS_READ:
-  	{
-  		argc = 3;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_read((int)args[0], (void*)args[1], (unsigned)args[2]);
-  		break;
-  	}
-  	case SYS_WRITE:
-  	{
-  		argc = 3;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_write((int)args[0], (const void*)args[1], (unsigned)args[2]);
-  		break;
-  	}
-  	case SYS_SEEK:
-  	{
-  		argc = 2;
-  		get_arguments(f->esp, args, argc);
-  		system_seek((int)args[0], (unsigned)args[1]);
-  		break;
-  	}
-  	case SYS_TELL:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_tell((int)args[0]);
-  		break;
-  	}
-  	case SYS_CLOSE:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		system_close((int)args[0]);
-  		break;
-  	}
-#ifdef VM
-  	case SYS_MMAP:
-  	{
-  		argc = 2;
-  		get_arguments(f->esp, args, argc);
-  		f->eax = system_mmap((int) args[0], (void *) args[1]);
-  		break;
-  	}
-  	case SYS_MUNMAP:
-  	{
-  		argc = 1;
-  		get_arguments(f->esp, args, argc);
-  		system_munmap((int) args[0]);
-  		break;
-  	}
-#endif
-  }
+  if(!copy_from_user(&number, f->esp, sizeof number)) system_exit(-1);
+  if(number < 0 || (unsigned) number >= SYSCALL_CNT) return;
+  desc = &syscall_table[number];
+  if(desc->handler == NULL) return;
+  get_arguments(f->esp, args, desc->argc);
+
+  /* Count the call up front: exit never returns to be timed. */
+  old_level = intr_disable();
+  syscall_stats[number].count++;
+  intr_set_level(old_level);
+
+  start = timer_cycles();
+  f->eax = desc->handler(args);
+  syscall_account(number, timer_cycles() - start);
 }
 
 static void
@@ -222,10 +386,17 @@ system_exec(const char* cmd_line)
 #ifdef DEBUG
 	printf("system_exec(): 진입\n");
 #endif
-	if(!is_user_vaddr((void*)cmd_line)) system_exit(-1);
 	pid_t pid;
 	struct thread* t = thread_current();
-	pid = process_execute(cmd_line);
+	char *cmd_copy = palloc_get_page(0);
+	if(!cmd_copy) return TID_ERROR;
+	if(strncpy_from_user(cmd_copy, cmd_line, PGSIZE) < 0)
+	{
+		palloc_free_page(cmd_copy);
+		system_exit(-1);
+	}
+	pid = process_execute(cmd_copy);
+	palloc_free_page(cmd_copy);
 	sema_down(&t->load_sema);
 	return t->child_status == LOAD_FAILED ? TID_ERROR : pid;
 }
@@ -245,10 +416,10 @@ system_create(const char* file, unsigned initial_size)
 #ifdef DEBUG
 	printf("system_create(): 진입\n");
 #endif
-	if(file==NULL || !is_user_vaddr((void *)file))
-		system_exit(-1);
+	char name[NAME_BUF_SIZE];
+	if(!get_file_name(name, file)) return false;
 	filesys_acquire();
-	bool result = filesys_create(file, initial_size);
+	bool result = filesys_create(name, initial_size);
 	filesys_release();
 	return result;
 }
@@ -259,10 +430,10 @@ system_remove(const char* file)
 #ifdef DEBUG
 	printf("system_remove(): 진입\n");
 #endif
-	if(file==NULL || !is_user_vaddr((void *)file))
-		system_exit(-1);
+	char name[NAME_BUF_SIZE];
+	if(!get_file_name(name, file)) return false;
 	filesys_acquire();
-	bool result = filesys_remove(file);
+	bool result = filesys_remove(name);
 	filesys_release();
 	return result;
 }
@@ -274,10 +445,10 @@ system_open(const char* file)
 	printf("system_open(): 진입\n");
 #endif
 	int fd = -1;
-	if(file==NULL || !is_user_vaddr((void *)file))
-		system_exit(-1);
+	char name[NAME_BUF_SIZE];
+	if(!get_file_name(name, file)) return -1;
 	filesys_acquire();
-	struct file *f = filesys_open(file);
+	struct file *f = filesys_open(name);
 	if(f) fd = add_thread_file_descriptor(f);
 	filesys_release();
 	return fd;
@@ -303,6 +474,11 @@ system_filesize(int fd)
 	return size;
 }
 
+/* File data moves between the file system and user memory through
+   a kernel page, a page at a time.  The user side of each chunk is
+   copied with file_lock released, since faulting in a user page
+   may itself need the file system. */
+
 static int
 system_read(int fd, void* buffer, unsigned size)
 {
@@ -310,31 +486,41 @@ system_read(int fd, void* buffer, unsigned size)
 	printf("system_read(): 진입\n");
 #endif
 	struct file *file;
-	unsigned i;
-	int bytes = -1;
-	if((void*)buffer==NULL || !is_user_vaddr(buffer))
-		system_exit(-1);
+	uint8_t *bounce;
+	unsigned bytes = 0;
+	if(buffer==NULL) system_exit(-1);
 	if(fd==STDIN_FILENO)
 	{
-		for(i=0; i<size; i++)
+		for(; bytes<size; bytes++)
 		{
-			*((uint8_t*)buffer + 1) = input_getc();
-			if(*((uint8_t*)buffer + 1) == 0) break;
+			uint8_t c = input_getc();
+			if(!copy_to_user((uint8_t*)buffer + bytes, &c, 1)) system_exit(-1);
+			if(c == 0) break;
 		}
-		bytes = i;
+		return bytes;
 	}
-	else
+	filesys_acquire();
+	file = get_file_from_fd(fd);
+	filesys_release();
+	if(!file) system_exit(-1);
+	bounce = palloc_get_page(0);
+	if(!bounce) return -1;
+	while(bytes < size)
 	{
+		unsigned chunk = size - bytes < PGSIZE ? size - bytes : PGSIZE;
+		int chunk_read;
 		filesys_acquire();
-		file = get_file_from_fd(fd);
-		if(!file)
+		chunk_read = file_read(file, bounce, chunk);
+		filesys_release();
+		if(!copy_to_user((uint8_t*)buffer + bytes, bounce, chunk_read))
 		{
-			filesys_release();
+			palloc_free_page(bounce);
 			system_exit(-1);
 		}
-		bytes = file_read(file, buffer, size);
-		filesys_release();
+		bytes += chunk_read;
+		if((unsigned) chunk_read < chunk) break;
 	}
+	palloc_free_page(bounce);
 	return bytes;
 }
 
@@ -344,27 +530,41 @@ system_write(int fd, const void* buffer, unsigned size)
 #ifdef DEBUG
 	printf("system_write(): 진입\n");
 #endif
-	struct file *file;
-	int result = -1;
-	if((void*)buffer==NULL || !is_user_vaddr(buffer)) system_exit(-1);
-	if(fd==STDOUT_FILENO)
-	{
-		putbuf(buffer, size);
-		result = size;
-	}
-	else
+	struct file *file = NULL;
+	uint8_t *bounce;
+	unsigned bytes = 0;
+	if(buffer==NULL) system_exit(-1);
+	if(fd!=STDOUT_FILENO)
 	{
 		filesys_acquire();
 		file = get_file_from_fd(fd);
-		if(!file)
+		filesys_release();
+		if(!file) system_exit(-1);
+	}
+	bounce = palloc_get_page(0);
+	if(!bounce) return -1;
+	while(bytes < size)
+	{
+		unsigned chunk = size - bytes < PGSIZE ? size - bytes : PGSIZE;
+		int chunk_written = chunk;
+		if(!copy_from_user(bounce, (const uint8_t*)buffer + bytes, chunk))
 		{
-			filesys_release();
+			palloc_free_page(bounce);
 			system_exit(-1);
 		}
-		result = file_write(file, buffer, size);
-		filesys_release();
+		if(fd==STDOUT_FILENO)
+			putbuf((const char *) bounce, chunk);
+		else
+		{
+			filesys_acquire();
+			chunk_written = file_write(file, bounce, chunk);
+			filesys_release();
+		}
+		bytes += chunk_written;
+		if((unsigned) chunk_written < chunk) break;
 	}
-	return result;
+	palloc_free_page(bounce);
+	return bytes;
 }
 
 static void
@@ -427,34 +627,154 @@ system_close(int fd)
 	filesys_release();
 }
 
-#ifdef VM
-bool 
-mmap_page_create(struct file *file, int32_t ofs, uint8_t *upage, uint32_t read_bytes, int mapid)
+/* Copies up to LENGTH bytes from IN_FD to OUT_FD inside the
+   kernel, starting at each file's current position.  The data
+   moves between buffer cache blocks directly instead of making a
+   round trip through a user buffer. */
+static int
+system_copy_range(int in_fd, int out_fd, unsigned length)
 {
 #ifdef DEBUG
-	printf("mmap_page_create(): 진입\n");
+	printf("system_copy_range(): 진입\n");
 #endif
-  struct thread *curr = thread_current();
-  struct page *page = malloc(sizeof(struct page));
-  if(!page) return false;
-  page->file = file;
-  page->offset = ofs;
-  page->upage = upage;
-  page->read_bytes = read_bytes;
-  page->loaded = false;
-  page->mmaped = true;
-  page->writable = true;
-  page->mapid = mapid;
-  page->busy = false;
-  if(!ptable_insert(page)) 
-  {
-  	free(page);
-  	return false;
-  }
-  list_push_back(&curr->mmap_list, &page->list_elem);
-  return true;
+	struct file *in, *out;
+	int bytes;
+	filesys_acquire();
+	in = get_file_from_fd(in_fd);
+	out = get_file_from_fd(out_fd);
+	if(!in || !out)
+	{
+		filesys_release();
+		system_exit(-1);
+	}
+	bytes = file_copy(out, in, length);
+	filesys_release();
+	return bytes;
+}
+
+/* Returns true if RING is a page-aligned user page. */
+static bool
+ring_page_valid(const void *ring)
+{
+	return ring != NULL && is_user_vaddr(ring)
+	       && (const void *) ring >= USER_VADDR_BOTTOM
+	       && pg_ofs(ring) == 0;
+}
+
+/* Registers SQ and CQ as the current process's submission and
+   completion queue pages for ring_enter().  Any earlier
+   registration is replaced. */
+static bool
+system_ring_setup(struct ring_sq *sq, struct ring_cq *cq)
+{
+	struct thread *cur = thread_current();
+	if(!ring_page_valid(sq) || !ring_page_valid(cq) || (void *) sq == (void *) cq)
+		return false;
+	cur->ring_sq = sq;
+	cur->ring_cq = cq;
+	return true;
+}
+
+/* Performs one ring submission and returns its result.  Errors
+   that would kill the process on the trap path, such as a bad
+   file descriptor, complete with -1 instead. */
+static int
+ring_dispatch(const struct ring_sqe *sqe)
+{
+	switch(sqe->opcode)
+	{
+		case RING_OP_READ:
+			if(sqe->fd != STDIN_FILENO && get_file_from_fd(sqe->fd) == NULL)
+				return -1;
+			return system_read(sqe->fd, sqe->buffer, sqe->length);
+		case RING_OP_WRITE:
+			if(sqe->fd != STDOUT_FILENO && get_file_from_fd(sqe->fd) == NULL)
+				return -1;
+			return system_write(sqe->fd, sqe->buffer, sqe->length);
+		case RING_OP_OPEN:
+			return system_open(sqe->buffer);
+		case RING_OP_CLOSE:
+			if(get_file_from_fd(sqe->fd) == NULL)
+				return -1;
+			system_close(sqe->fd);
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+/* Processes up to TO_SUBMIT queued submissions in order, posting
+   one completion for each, and returns the number processed.
+   Processing stops early if the completion queue fills up; the
+   remaining submissions stay queued for the next call.
+
+   Submissions run synchronously in the caller's context: the
+   process's address space, page table and file descriptors all
+   belong to this thread, and every file system operation is
+   serialized by file_lock, so a separate worker thread would not
+   overlap any disk waits.  The saving comes from handling the
+   whole batch with a single trap. */
+static int
+system_ring_enter(unsigned to_submit)
+{
+	struct thread *cur = thread_current();
+	struct ring_sq *sq = cur->ring_sq;
+	struct ring_cq *cq = cur->ring_cq;
+	unsigned sq_head, sq_tail, cq_head, cq_tail;
+	unsigned done = 0;
+	if(!sq || !cq) return -1;
+	if(!copy_from_user(&sq_head, &sq->head, sizeof sq_head)
+	   || !copy_from_user(&sq_tail, &sq->tail, sizeof sq_tail)
+	   || !copy_from_user(&cq_head, &cq->head, sizeof cq_head)
+	   || !copy_from_user(&cq_tail, &cq->tail, sizeof cq_tail))
+		system_exit(-1);
+	while(done < to_submit && sq_head != sq_tail
+	      && cq_tail - cq_head < RING_ENTRIES)
+	{
+		struct ring_sqe sqe;
+		struct ring_cqe cqe;
+		if(!copy_from_user(&sqe, &sq->entries[sq_head % RING_ENTRIES], sizeof sqe))
+			system_exit(-1);
+		cqe.result = ring_dispatch(&sqe);
+		cqe.user_data = sqe.user_data;
+		if(!copy_to_user(&cq->entries[cq_tail % RING_ENTRIES], &cqe, sizeof cqe))
+			system_exit(-1);
+		sq_head++;
+		cq_tail++;
+		done++;
+	}
+	if(!copy_to_user(&sq->head, &sq_head, sizeof sq_head)
+	   || !copy_to_user(&cq->tail, &cq_tail, sizeof cq_tail))
+		system_exit(-1);
+	return done;
+}
+
+static bool
+system_sysstat(int number, struct sysstat *ustat)
+{
+	struct sysstat stat;
+	enum intr_level old_level;
+	if(number < 0 || (unsigned) number >= SYSCALL_CNT
+	   || syscall_table[number].handler == NULL)
+		return false;
+	old_level = intr_disable();
+	stat = syscall_stats[number];
+	intr_set_level(old_level);
+	strlcpy(stat.name, syscall_table[number].name, sizeof stat.name);
+	if(!copy_to_user(ustat, &stat, sizeof stat)) system_exit(-1);
+	return true;
+}
+
+static int
+system_clock(struct timespec *uts)
+{
+	uint64_t ns = timer_ns();
+	struct timespec ts;
+	ts.tv_sec = ns / 1000000000;
+	ts.tv_nsec = ns % 1000000000;
+	if(!copy_to_user(uts, &ts, sizeof ts)) system_exit(-1);
+	return 0;
 }
-#endif
 
 #ifdef VM
 static int
@@ -465,73 +785,56 @@ system_mmap (int fd, void *addr)
 #endif
 	/* thread에서  fd 이용하여 file 가져오기 */
 	struct file *f;
-	struct page *page;
+	struct file *file;
+	off_t length;
+	int mapid;
 	filesys_acquire();
 	f = get_file_from_fd(fd);
 	filesys_release();
 	if(!f || !is_user_vaddr(addr) || addr < USER_VADDR_BOTTOM || ((uint32_t) addr % PGSIZE) != 0) return -1;
-	struct file *file = file_reopen(f);
-	if(!file || file_length(f)==0) return -1;
-	int32_t offset = 0;
-	int mapid = ++thread_current()->mapid;
-	uint32_t read_bytes = file_length(file);
-	while(read_bytes > 0)
+	filesys_acquire();
+	file = file_reopen(f);
+	length = file ? file_length(file) : 0;
+	filesys_release();
+	if(!file) return -1;
+	/* 영역만 등록하고 page는 fault가 날 때 만든다 */
+	mapid = thread_current()->mapid + 1;
+	if(length == 0 || !vma_add(file, 0, addr, length, length, true, mapid))
 	{
-  	uint32_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-  	if(!mmap_page_create(file, offset, addr+offset, page_read_bytes, mapid))
-  	{
-  		system_munmap(mapid);
-  		return -1;
-  	}
-  	read_bytes -= page_read_bytes;
-    offset += PGSIZE;
+		filesys_acquire();
+		file_close(file);
+		filesys_release();
+		return -1;
 	}
+	thread_current()->mapid = mapid;
 	return mapid;
 }
 #endif
 
 #ifdef VM
+static pid_t
+system_fork(void)
+{
+#ifdef DEBUG
+	printf("system_fork(): 진입\n");
+#endif
+	struct thread *t = thread_current();
+	/* user mode에서 들어온 interrupt frame은 kernel stack 맨 위에 있다 */
+	struct intr_frame *f = (struct intr_frame *) ((uint8_t *) t + PGSIZE) - 1;
+	pid_t pid = process_fork(f);
+	sema_down(&t->load_sema);
+	return t->child_status == LOAD_FAILED ? TID_ERROR : pid;
+}
+
 static void
 system_munmap(int mapid)
 {
 #ifdef DEBUG
 	printf("system_munmap(): 진입\n");
 #endif
-	struct thread *curr = thread_current();
-	struct list_elem *e;
-	struct page *page;
-	struct file *file = NULL;
-	if(list_empty(&curr->mmap_list)) return;
-	bool file_put = false;
-	for(e=list_front(&curr->mmap_list);e!=list_end(&curr->mmap_list);)
-	{
-		page = list_entry(e, struct page, list_elem);
-		e = list_next(e);
-		if(page->mapid != mapid) continue;
-		list_remove(&page->list_elem);
-    if(pagedir_is_dirty(curr->pagedir, page->upage))
-    {
-      filesys_acquire();
-      file_write_at(page->file, page->upage, page->read_bytes, page->offset);
-      filesys_release();
-    }
-    frame_free(pagedir_get_page(curr->pagedir, page->upage));
-    pagedir_clear_page(curr->pagedir, page->upage);
-		hash_delete(&curr->page_table, &page->hash_elem);
-    if(!file_put)
-    {
-      file = page->file;
-      file_put = true;
-    }
-		free(page);
-	}
-	if(file)
-  {
-    filesys_acquire();
-    file_close(file);
-    filesys_release();
-  }
-	return;
+	struct vma *vma = vma_find_mapid(mapid);
+	if(vma && mapid != MAP_FAILED)
+		vma_destroy(vma);
 }
 #endif
 
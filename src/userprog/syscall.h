@@ -6,6 +6,7 @@
 #define USER_VADDR_BOTTOM ((void *) 0x08048000)
 
 void syscall_init (void);
+void syscall_print_stats (void);
 void system_exit(int status);
 void filesys_acquire(void);
 void filesys_release(void);
@@ -1,26 +1,148 @@
 #include "vm/frame.h"
 #include <stdbool.h>
 #include <stddef.h>
-#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include <round.h>
 #include <user/syscall.h>
 #include "filesys/file.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/pagedir.h"
+#include "userprog/process.h"
 #include "userprog/syscall.h"
 #include "vm/swap.h"
+#include "vm/zswap.h"
 
 static struct lock frame_lock;
 
+/* text table: 실행 file의 read-only page를 담은 frame들,
+   (inode, offset)으로 찾는다.  frame_lock으로 보호한다. */
+static struct hash text_table;
+
+/* 0으로 채워진 read-only frame 하나.  0으로 채울 page를 읽기만
+   하면 이 frame을 mapping하고, 처음 쓸 때 frame_cow()가 새 frame을
+   준다.  kernel pool에서 받으므로 frame table에 없고, 쫓겨나거나
+   swap으로 가지 않는다. */
+static void *zero_kpage;
+
+/* frame table: user pool의 page 하나당 struct frame 하나.
+   frames[i]는 user_base부터 i번째 page를 나타내고, 비어 있으면
+   alloc_page가 NULL. */
+static struct frame *frames;
+static uint8_t *user_base;
+static size_t frame_cnt;
+
+/* clock 알고리즘의 hand.  eviction 사이에도 유지된다. */
+static size_t clock_hand;
+
+/* pageout daemon.  빈 frame이 free_low 아래로 내려가면 깨어나서
+   free_high까지 미리 쫓아내 둔다.  그래서 fault를 낸 thread가
+   직접 eviction I/O를 하는 일은 거의 없다. */
+static struct semaphore pageout_wake;
+static bool pageout_pending;
+static size_t free_low, free_high;
+
+/* 통계: 누가 쫓아냈는가 */
+static long long pageout_evict_cnt;
+static long long direct_evict_cnt;
+
+/* 통계: copy-on-write fault */
+static long long cow_copy_cnt;
+static long long cow_reuse_cnt;
+
+/* 통계: 다른 process가 올려 둔 text frame을 mapping한 수 */
+static long long text_share_cnt;
+
+/* 통계: zero frame을 mapping한 수와 그중 나중에 쓴 수 */
+static long long zero_map_cnt;
+static long long zero_cow_cnt;
+
+static thread_func pageout_daemon;
+static size_t frame_evict(void);
+static hash_hash_func text_hash;
+static hash_less_func text_less;
+
 //#define DEBUG
 
-/* frame table manage를 위해, table(list)와 manager(lock) 초기화 */
+/* frame table manage를 위해, table(array)와 manager(lock) 초기화 */
 void
 frame_init(void)
 {
+	size_t size;
+
 	lock_init(&frame_lock);
-	list_init(&frame_table);
+	user_base = palloc_user_pool(&frame_cnt);
+	size = frame_cnt * sizeof *frames;
+	frames = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+	                             DIV_ROUND_UP(size, PGSIZE));
+	clock_hand = 0;
+	hash_init(&text_table, text_hash, text_less, NULL);
+	zero_kpage = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+
+	free_low = frame_cnt / 32 + SWAP_CLUSTER_MAX;
+	free_high = 2 * free_low;
+	sema_init(&pageout_wake, 0);
+	pageout_pending = false;
+	thread_create("pageout", PRI_DEFAULT + 1, pageout_daemon, NULL);
+}
+
+/* 빈 frame이 free_high개가 될 때까지 cluster 단위로 쫓아낸다. */
+static void
+pageout_daemon(void *aux UNUSED)
+{
+	for (;;)
+	{
+		sema_down(&pageout_wake);
+		while (palloc_user_free_cnt() < free_high)
+		{
+			size_t freed;
+
+			frame_acquire();
+			freed = frame_evict();
+			frame_release();
+			if (freed == 0)
+				break;
+			pageout_evict_cnt += freed;
+		}
+		pageout_pending = false;
+	}
+}
+
+/* 빈 frame이 free_low 아래면 pageout daemon을 깨운다. */
+static void
+pageout_poke(void)
+{
+	if (!pageout_pending && palloc_user_free_cnt() < free_low)
+	{
+		pageout_pending = true;
+		sema_up(&pageout_wake);
+	}
+}
+
+/* 빈 frame을 CNT개 더 써도 free_low 밑으로 내려가지 않으면 true.
+   fault-around처럼 당장 필요하지 않은 page를 위한 것이다. */
+bool
+frame_spare(size_t cnt)
+{
+	return palloc_user_free_cnt() >= free_low + cnt;
+}
+
+/* frame 통계 출력 */
+void
+frame_print_stats(void)
+{
+	printf("Frame: %lld pages evicted by pageout, %lld by faults\n",
+	       pageout_evict_cnt, direct_evict_cnt);
+	printf("Frame: %lld copy-on-write copies, %lld reused in place\n",
+	       cow_copy_cnt, cow_reuse_cnt);
+	printf("Frame: %lld text pages shared between processes\n",
+	       text_share_cnt);
+	printf("Frame: %lld zero page mappings, %lld copied on write\n",
+	       zero_map_cnt, zero_cow_cnt);
 }
 
 /* frame manager(lock) 관련, acquire 및 release */
@@ -36,102 +158,458 @@ frame_release(void)
 	lock_release(&frame_lock);
 }
 
+/* KPAGE에 해당하는 frame table entry, user pool 밖이면 NULL */
+static struct frame *
+frame_lookup(void *kpage)
+{
+	size_t idx;
+
+	if ((uint8_t *) kpage < user_base)
+		return NULL;
+	idx = pg_no(kpage) - pg_no(user_base);
+	return idx < frame_cnt ? &frames[idx] : NULL;
+}
+
 /* frame table에 새로운 frame 넣기 */
 void
 frame_set_elem(void *frame, struct page* page)
 {
-	/* page frame mapping table 구성 */
-	/* frame elem 구성 */
-	struct frame *new_frame = malloc(sizeof(struct frame));
-	new_frame->kpage = frame;
-	new_frame->frame_owner = thread_current();
-	new_frame->alloc_page = page;
-	/* frame table(list)에 넣어야 함 */
+	struct frame *f = frame_lookup(frame);
+
+	ASSERT(f != NULL);
 	frame_acquire();
-	list_push_back(&frame_table, &new_frame->elem);
+	f->kpage = frame;
+	f->alloc_page = page;
+	f->refcnt = 1;
+	page->page_owner = thread_current();
 	frame_release();
-	return;
 }
 
-void *
-frame_victim(enum palloc_flags flags)
+/* text table은 (inode, offset)으로 hashing */
+static unsigned
+text_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry(e, struct frame, text_elem);
+	return hash_bytes(&f->text_inode, sizeof f->text_inode)
+	       ^ hash_int(f->text_offset);
+}
+
+static bool
+text_less(const struct hash_elem *a_, const struct hash_elem *b_,
+          void *aux UNUSED)
+{
+	const struct frame *a = hash_entry(a_, struct frame, text_elem);
+	const struct frame *b = hash_entry(b_, struct frame, text_elem);
+
+	if (a->text_inode != b->text_inode)
+		return a->text_inode < b->text_inode;
+	return a->text_offset < b->text_offset;
+}
+
+/* F가 text table에 있으면 뺀다.  frame_lock을 잡고 불러야 한다. */
+static void
+frame_remove_text(struct frame *f)
 {
+	if (f->text_inode == NULL)
+		return;
+	hash_delete(&text_table, &f->text_elem);
+	f->text_inode = NULL;
+}
+
+/* 다른 process가 이미 올려 둔 PAGE의 text frame이 있으면 현재
+   thread에 read-only로 mapping하고 true.  PAGE는 실행 file의
+   read-only page여야 한다. */
+bool
+frame_map_text(struct page *page)
+{
+	struct thread *cur = thread_current();
+	struct frame key, *f;
+	struct hash_elem *e;
+
+	key.text_inode = file_get_inode(page->file);
+	key.text_offset = page->offset;
 	frame_acquire();
-	struct frame *frame = NULL;
-	struct page *page;
-	struct thread *owner;
-	struct list_elem *e;
-	e = list_begin(&frame_table);
-// 	while(true)
-// 	{
-// 		frame = list_entry(e, struct frame, elem);
-// 		owner = frame->frame_owner;
-// 		page = frame->alloc_page;
-// 		if(!page->busy)
-// 		{
-// 			if(pagedir_is_dirty(owner->pagedir, page->upage) || page->swaped)
-// 			{
-// 				if (page->mapid != MAP_FAILED)
-// 				{
-// 					filesys_acquire ();
-// 					file_write_at(page->file, page->upage, page->read_bytes, page->offset);
-// 					filesys_release ();
-// 				}
-// 				else
-// 				{
-// 					page->swaped = true;
-// 					page->swap_index = swap_out(frame->kpage);
-// 				}
-// 			}
-// 			page->loaded = false;
-// 			list_remove(e);
-// 			pagedir_clear_page(owner->pagedir, page->upage);
-// 			palloc_free_page(frame->kpage);
-// 			free(frame);
-// #ifdef DEBUG
-// 			printf("frame_victim에서 누구 쫓아내고 return\n");
-// #endif
-// 			return palloc_get_page(PAL_USER | flags);
-// 		}
-// 		e = list_next(e);
-// 		if(e==list_end(&frame_table)) return NULL;
-// 	}
-	while(true)
-	{
-		frame = list_entry(e, struct frame, elem);
-		owner = frame->frame_owner;
-		page = frame->alloc_page;
-		if(!page->busy)
+	e = hash_find(&text_table, &key.text_elem);
+	f = e != NULL ? hash_entry(e, struct frame, text_elem) : NULL;
+	if (f == NULL || f->alloc_page->read_bytes != page->read_bytes
+	    || pagedir_get_page(cur->pagedir, page->upage) != NULL
+	    || !pagedir_set_page(cur->pagedir, page->upage, f->kpage, false))
+	{
+		frame_release();
+		return false;
+	}
+	page->page_owner = cur;
+	page->cow_next = f->alloc_page->cow_next;
+	f->alloc_page->cow_next = page;
+	f->refcnt++;
+	text_share_cnt++;
+	frame_release();
+	return true;
+}
+
+/* file에서 막 읽어 온 PAGE의 frame KPAGE를 text table에 올려서
+   다음 process가 frame_map_text()로 찾게 한다.  같은 page를 다른
+   process가 먼저 올렸으면 그대로 둔다. */
+void
+frame_add_text(void *kpage, struct page *page)
+{
+	struct frame *f = frame_lookup(kpage);
+
+	ASSERT(f != NULL);
+	frame_acquire();
+	f->text_inode = file_get_inode(page->file);
+	f->text_offset = page->offset;
+	if (hash_insert(&text_table, &f->text_elem) != NULL)
+		f->text_inode = NULL;
+	frame_release();
+}
+
+/* PAGE를 현재 thread에 zero frame으로 read-only mapping한다. */
+bool
+frame_map_zero(struct page *page)
+{
+	if (!install_page(page->upage, zero_kpage, false))
+		return false;
+	page->page_owner = thread_current();
+	zero_map_cnt++;
+	return true;
+}
+
+/* F를 공유하는 page 목록에서 PAGE를 뺀다.  frame_lock을 잡고
+   불러야 한다.  refcnt가 0이 되면 frame을 돌려준다. */
+static void
+frame_unlink(struct frame *f, struct page *page)
+{
+	struct page **pp;
+
+	for (pp = &f->alloc_page; *pp != page; pp = &(*pp)->cow_next)
+		ASSERT(*pp != NULL);
+	*pp = page->cow_next;
+	page->cow_next = NULL;
+	if (--f->refcnt == 0)
+	{
+		frame_remove_text(f);
+		palloc_free_page(f->kpage);
+		f->alloc_page = NULL;
+		f->kpage = NULL;
+	}
+}
+
+/* fork: PAGE가 올라와 있으면 그 frame을 COPY와 공유한다.  COPY는
+   현재 thread(자식)의 page다.  쓰기 가능한 page는 양쪽 다 read-only로
+   mapping해서 처음 쓸 때 frame_cow()가 복사하게 한다.
+   PAGE가 올라와 있지 않거나 mapping에 실패하면 false. */
+bool
+frame_share(struct page *page, struct page *copy)
+{
+	uint32_t *pd;
+	void *kpage;
+	struct frame *f;
+
+	frame_acquire();
+	if (!page->loaded)
+	{
+		frame_release();
+		return false;
+	}
+	pd = page->page_owner->pagedir;
+	kpage = pagedir_get_page(pd, page->upage);
+	copy->page_owner = thread_current();
+	if (!pagedir_set_page(copy->page_owner->pagedir, copy->upage, kpage, false))
+	{
+		frame_release();
+		return false;
+	}
+	copy->loaded = true;
+	/* zero frame은 원래 read-only이고 공유 목록도 없다 */
+	if (kpage == zero_kpage)
+	{
+		frame_release();
+		return true;
+	}
+	f = frame_lookup(kpage);
+	ASSERT(f != NULL && f->alloc_page != NULL);
+	if (page->writable)
+		pagedir_set_writable(pd, page->upage, false);
+	/* 부모가 이미 고친 내용이면 자식 쪽도 쫓아낼 때 swap으로 가야 한다 */
+	pagedir_set_dirty(copy->page_owner->pagedir, copy->upage,
+	                  pagedir_is_dirty(pd, page->upage));
+	copy->cow_next = page->cow_next;
+	page->cow_next = copy;
+	f->refcnt++;
+	frame_release();
+	return true;
+}
+
+/* PAGE가 F를 공유하는 page 목록에 있으면 true.  frame_lock을 잡고
+   불러야 한다. */
+static bool
+frame_has_page(struct frame *f, struct page *page)
+{
+	struct page *p;
+
+	for (p = f->alloc_page; p != NULL; p = p->cow_next)
+		if (p == page)
+			return true;
+	return false;
+}
+
+/* 현재 thread가 공유 중인 frame에 mapping된 PAGE에 쓰려고 할 때.
+   혼자 쓰고 있으면 그대로 쓰기 가능하게 바꾸고, 아니면 새 frame에
+   복사해서 mapping을 바꾼다.  zero frame이면 0으로 채운 새 frame을
+   준다.  PAGE는 busy여야 한다.
+
+   PAGE가 busy가 되기 전에 쫓겨났으면 아무것도 하지 않고 true를
+   return한다.  다시 fault가 나서 page_load()가 읽어 온다.  PAGE의
+   주소에 frame table에 없는 page(CLOCK_PAGE 등)가 mapping돼 있으면
+   다시 해도 소용없으므로 false. */
+bool
+frame_cow(struct page *page)
+{
+	uint32_t *pd = thread_current()->pagedir;
+	struct frame *f, *nf;
+	void *old, *new;
+
+	frame_acquire();
+	old = pagedir_get_page(pd, page->upage);
+	if (old != NULL && old != zero_kpage && frame_lookup(old) == NULL)
+	{
+		frame_release();
+		return false;
+	}
+	if (!page->loaded || old == NULL)
+	{
+		frame_release();
+		return true;
+	}
+	if (old == zero_kpage)
+	{
+		/* zero frame은 frame table에 없으므로 쫓겨나지 않는다 */
+		frame_release();
+		new = frame_alloc(PAL_USER | PAL_ZERO, page);
+		pagedir_clear_page(pd, page->upage);
+		pagedir_set_page(pd, page->upage, new, true);
+		pagedir_set_dirty(pd, page->upage, true);
+		zero_cow_cnt++;
+		return true;
+	}
+	f = frame_lookup(old);
+	ASSERT(f != NULL && f->kpage == old);
+	if (f->refcnt == 1)
+	{
+		pagedir_set_writable(pd, page->upage, true);
+		cow_reuse_cnt++;
+		frame_release();
+		return true;
+	}
+	frame_release();
+
+	/* 이제 PAGE가 busy라서 old는 쫓겨나지 않는다.  새 frame의
+	   cow_next는 잠시 old의 목록을 가리키지만, 역시 busy라서 아무도
+	   따라가지 않는다.  그래도 unlink 전에 다시 확인한다. */
+	new = frame_alloc(PAL_USER, page);
+	nf = frame_lookup(new);
+	frame_acquire();
+	if (f->kpage != old || !frame_has_page(f, page)
+	    || pagedir_get_page(pd, page->upage) != old)
+	{
+		nf->alloc_page = NULL;
+		nf->kpage = NULL;
+		nf->refcnt = 0;
+		palloc_free_page(new);
+		frame_release();
+		return true;
+	}
+	memcpy(new, old, PGSIZE);
+	frame_unlink(f, page);
+	pagedir_clear_page(pd, page->upage);
+	pagedir_set_page(pd, page->upage, new, true);
+	pagedir_set_dirty(pd, page->upage, true);
+	cow_copy_cnt++;
+	frame_release();
+	return true;
+}
+
+/* VICTIM을 공유하는 모든 page의 mapping을 끊고 page 상태를 갱신한다.
+   dirty한 anonymous page는 swap으로 보내야 하므로 true를 return하고,
+   dirty한 mmap page면 file에 다시 쓰도록 *WRITE_BACK을 true로 한다.
+   interrupt를 끄고 불러야 한다: 그동안 owner가 다른 CPU에서 돌기
+   시작하면 그 CPU의 TLB에 mapping이 남는다. */
+static bool
+frame_unmap(struct frame *victim, bool *write_back)
+{
+	struct page *page = victim->alloc_page;
+	struct page *p;
+	bool dirty = false;
+	bool to_swap;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (p = page; p != NULL; p = p->cow_next)
+		dirty = dirty || pagedir_is_dirty(p->page_owner->pagedir, p->upage);
+	to_swap = dirty && page->mapid == MAP_FAILED;
+	*write_back = dirty && !to_swap;
+
+	/* owner가 fault를 내더라도 swap에서 읽도록, mapping을 끊기 전에
+	   표시한다.  swap_index는 frame_lock을 놓기 전에 채워진다. */
+	for (p = page; p != NULL; p = p->cow_next)
+	{
+		if (to_swap)
+			p->swaped = true;
+		p->loaded = false;
+		pagedir_clear_page(p->page_owner->pagedir, p->upage);
+	}
+	return to_swap;
+}
+
+/* F를 공유하는 page의 owner 중 다른 CPU에서 돌고 있는 thread가
+   있으면 true.  PTE를 지워도 그 CPU의 TLB에는 mapping이 남아 있어서
+   지금은 쫓아낼 수 없다.  interrupt를 끄고 불러야 한다: 그래야 다른
+   CPU가 thread를 바꾸지 못한다. */
+static bool
+frame_running_elsewhere(struct frame *f)
+{
+	struct page *p;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (p = f->alloc_page; p != NULL; p = p->cow_next)
+		if (p->page_owner->status == THREAD_RUNNING
+		    && p->page_owner != thread_current())
+			return true;
+	return false;
+}
+
+/* F를 지금 쫓아내도 되면 true.  공유하는 page 중 하나라도 busy거나
+   최근에 접근됐으면 false이고, accessed bit는 모두 지운다. */
+static bool
+frame_evictable(struct frame *f)
+{
+	struct page *p;
+	bool evictable = true;
+
+	for (p = f->alloc_page; p != NULL; p = p->cow_next)
+	{
+		uint32_t *pd = p->page_owner->pagedir;
+
+		if (p->busy)
+			return false;
+		if (pagedir_is_accessed(pd, p->upage))
+		{
+			pagedir_set_accessed(pd, p->upage, false);
+			evictable = false;
+		}
+	}
+	return evictable;
+}
+
+/* clock hand 위치부터 돌면서 accessed bit가 꺼진 frame을 최대
+   SWAP_CLUSTER_MAX개 골라 쫓아내고, 쫓아낸 frame 수를 return.
+   swap으로 갈 page들은 연속된 slot에 한 번에 쓴다.  fork 뒤 공유된
+   frame은 page마다 따로 swap에 맡긴다.
+   frame_lock을 잡고 불러야 한다.
+   두 바퀴를 돌아도 쫓아낼 frame이 없으면 0. */
+static size_t
+frame_evict(void)
+{
+	struct frame *victims[SWAP_CLUSTER_MAX];
+	bool to_swap[SWAP_CLUSTER_MAX], write_back[SWAP_CLUSTER_MAX];
+	void *swap_pages[SWAP_CLUSTER_MAX];
+	struct page *swap_victims[SWAP_CLUSTER_MAX];
+	size_t slots[SWAP_CLUSTER_MAX];
+	size_t victim_cnt = 0, swap_cnt = 0;
+	size_t i;
+
+	for (i = 0; i < 2 * frame_cnt && victim_cnt < SWAP_CLUSTER_MAX; i++)
+	{
+		struct frame *frame = &frames[clock_hand];
+		enum intr_level old_level;
+
+		clock_hand = (clock_hand + 1) % frame_cnt;
+		if (frame->alloc_page == NULL)
+			continue;
+
+		/* 고르고 mapping을 끊을 때까지 owner가 다른 CPU에서 돌기
+		   시작하지 못하도록 interrupt를 끈다. */
+		old_level = intr_disable();
+		if (!frame_running_elsewhere(frame) && frame_evictable(frame))
+		{
+			to_swap[victim_cnt] = frame_unmap(frame, &write_back[victim_cnt]);
+			victims[victim_cnt++] = frame;
+		}
+		intr_set_level(old_level);
+	}
+	if (victim_cnt == 0)
+		return 0;
+
+	for (i = 0; i < victim_cnt; i++)
+	{
+		struct page *p;
+
+		if (write_back[i])
+		{
+			struct page *page = victims[i]->alloc_page;
+
+			filesys_acquire();
+			file_write_at(page->file, victims[i]->kpage, page->read_bytes,
+				      page->offset);
+			filesys_release();
+		}
+		if (!to_swap[i])
+			continue;
+		for (p = victims[i]->alloc_page->cow_next; p != NULL; p = p->cow_next)
+			if (!zswap_store(p, victims[i]->kpage))
+				p->swap_index = swap_out(victims[i]->kpage);
+		if (!zswap_store(victims[i]->alloc_page, victims[i]->kpage))
+		{
+			swap_pages[swap_cnt] = victims[i]->kpage;
+			swap_victims[swap_cnt++] = victims[i]->alloc_page;
+		}
+	}
+
+	if (swap_cnt > 0)
+	{
+		/* 연속된 slot이 없으면 한 page씩 */
+		if (!swap_out_cluster(swap_pages, slots, swap_cnt))
+			for (i = 0; i < swap_cnt; i++)
+				slots[i] = swap_out(swap_pages[i]);
+		for (i = 0; i < swap_cnt; i++)
+			swap_victims[i]->swap_index = slots[i];
+	}
+
+	/* 다 쓴 뒤에야 frame을 돌려준다 */
+	for (i = 0; i < victim_cnt; i++)
+	{
+		struct page *p, *next;
+
+		for (p = victims[i]->alloc_page; p != NULL; p = next)
 		{
-			if(pagedir_is_accessed(owner->pagedir, page->upage))
-				pagedir_set_accessed(owner->pagedir, page->upage, false);
-			else
-			{	
-				if(pagedir_is_dirty(owner->pagedir, page->upage))
-				{
-					if(page->mapid != MAP_FAILED)
-	        {
-	          filesys_acquire();
-	          file_write_at(page->file, page->upage, page->read_bytes, page->offset);
-	          filesys_release();
-	        }
-	        else
-	        {
-						page->swaped = true;
-						page->swap_index = swap_out(frame->kpage);
-					}
-				}
-				page->loaded = false;
-				list_remove(e);
-				pagedir_clear_page(owner->pagedir, page->upage);
-				palloc_free_page(frame->kpage);
-				free(frame);
-				return palloc_get_page(PAL_USER | flags);
-		  }
+			next = p->cow_next;
+			p->cow_next = NULL;
 		}
-	  e = list_next(e);
-	  if(e==list_end(&frame_table)) e=list_begin(&frame_table);
+		frame_remove_text(victims[i]);
+		palloc_free_page(victims[i]->kpage);
+		victims[i]->alloc_page = NULL;
+		victims[i]->refcnt = 0;
+		victims[i]->kpage = NULL;
 	}
+	return victim_cnt;
+}
+
+/* pageout daemon이 따라오지 못했을 때, fault를 낸 thread가 직접
+   쫓아내고 새 page를 할당해 return.  frame_lock을 잡은 채로
+   return한다.  쫓아낼 frame이 없으면 NULL. */
+void *
+frame_victim(enum palloc_flags flags)
+{
+	size_t freed;
+
+	frame_acquire();
+	freed = frame_evict();
+	if (freed == 0)
+		return NULL;
+	direct_evict_cnt += freed;
+	return palloc_get_page(PAL_USER | flags);
 }
 
 /* frame table 생성을 위함 */
@@ -140,6 +618,7 @@ void *
 frame_alloc(enum palloc_flags flags, struct page* page)
 {
 	void *frame = palloc_get_page(PAL_USER | flags);
+	pageout_poke();
 	/* page 할당 성공한 경우, */
 	if(frame)
 	{
@@ -160,21 +639,22 @@ frame_alloc(enum palloc_flags flags, struct page* page)
 	}
 }
 
+/* 현재 thread의 page를 FRAME에서 뗀다.  FRAME을 공유하는 다른 page가
+   없으면 frame도 돌려준다. */
 void
 frame_free(void *frame)
 {
+	struct frame *f = frame_lookup(frame);
+	struct page *p;
+
+	if (f == NULL)
+		return;
 	frame_acquire();
-	struct list_elem *e;
-	for(e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e))
-	{
-		struct frame *tmp_frame = list_entry(e, struct frame, elem);
-		if(tmp_frame->kpage == frame)
+	for (p = f->alloc_page; p != NULL; p = p->cow_next)
+		if (p->page_owner == thread_current())
 		{
-			list_remove(e);
-			palloc_free_page(tmp_frame->kpage);
-			free(tmp_frame);
+			frame_unlink(f, p);
 			break;
 		}
-	}
 	frame_release();
 }
@@ -1,18 +1,24 @@
 #ifndef VM_FRAME_H
 #define VM_FRAME_H
 
-#include <list.h>
+#include <hash.h>
+#include "filesys/off_t.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 
-struct list frame_table;
-
+/* frame table entry.  user pool의 page마다 하나씩 있다.
+   fork 뒤에는 여러 process의 page가 한 frame을 read-only로 공유할
+   수 있다.  공유하는 page들은 alloc_page부터 page->cow_next로
+   이어진다.  실행 file의 read-only page는 (inode, offset)으로 text
+   table에 올려 두고, 같은 file을 실행하는 process들이 공유한다. */
 struct frame
 {
-	struct thread *frame_owner;
 	void *kpage;
-	struct list_elem elem;
-	struct page *alloc_page;
+	struct page *alloc_page;	/* 비어 있는 frame이면 NULL */
+	unsigned refcnt;		/* 이 frame을 mapping한 page 수 */
+	struct inode *text_inode;	/* text table에 있으면 file의 inode */
+	off_t text_offset;		/* 그 file 안에서의 위치 */
+	struct hash_elem text_elem;	/* text table element */
 };
 
 void frame_init(void);
@@ -23,5 +29,12 @@ void *frame_alloc(enum palloc_flags flags, struct page* page);
 void *frame_victim(enum palloc_flags flags);
 void frame_delete_elem(void *frame);
 void frame_free(void *frame);
+void frame_print_stats(void);
+bool frame_spare(size_t cnt);
+bool frame_share(struct page *page, struct page *copy);
+bool frame_cow(struct page *page);
+bool frame_map_text(struct page *page);
+bool frame_map_zero(struct page *page);
+void frame_add_text(void *kpage, struct page *page);
 
 #endif /* vm/frame.h */
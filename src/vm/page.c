@@ -1,9 +1,12 @@
 #include "vm/page.h"
+#include <bitmap.h>
 #include <debug.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include <hash.h>
+#include <round.h>
 #include <user/syscall.h>
 #include "filesys/file.h"
 #include "threads/malloc.h"
@@ -13,11 +16,19 @@
 #include "userprog/syscall.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
+#include "vm/zswap.h"
 #include "vm/page.h"
 #include "userprog/process.h"
 
 //#define DEBUG
 
+/* fault-around로 한 번에 올리는 page 수의 범위 */
+#define FAULT_AROUND_MIN 4
+#define FAULT_AROUND_MAX 32
+
+/* fault-around로 미리 올린 page 수 */
+static long long fault_around_cnt;
+
 static void
 page_destroy_function (struct hash_elem *e, void *aux UNUSED);
 
@@ -62,6 +73,8 @@ page_create(struct file *file, off_t ofs, uint8_t *upage,
 	page->mmaped = false;
 	page->mapid = -1;
 	page->busy = false;
+	page->zswap = NULL;
+	page->cow_next = NULL;
 	return page;
 }
 
@@ -75,8 +88,9 @@ ptable_insert(struct page *page)
   return false;
 }
 
-struct page*
-ptable_lookup(void* addr)
+/* ADDR이 속한 page를 page table에서 찾는다.  없으면 NULL. */
+struct page *
+ptable_find(void *addr)
 {
 	void* rounded_addr;
 	rounded_addr = pg_round_down(addr);
@@ -89,10 +103,203 @@ ptable_lookup(void* addr)
 	return NULL;
 }
 
+/* ADDR을 포함하는 영역, 없으면 NULL */
+static struct vma *
+vma_lookup(const void *addr)
+{
+	struct list *vma_list = &thread_current()->vma_list;
+	struct list_elem *e;
+
+	for (e = list_begin(vma_list); e != list_end(vma_list); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+
+		if ((const uint8_t *) addr < vma->start)
+			break;
+		if ((const uint8_t *) addr < vma->end)
+			return vma;
+	}
+	return NULL;
+}
+
+/* ADDR이 속한 page를 찾는다.  아직 struct page가 없지만 영역
+   안이면 영역에서 만들어 page table에 넣는다.  어느 쪽도 아니면
+   NULL. */
+struct page*
+ptable_lookup(void* addr)
+{
+	struct page *page = ptable_find(addr);
+	uint8_t *upage = pg_round_down(addr);
+	struct vma *vma;
+	size_t delta;
+	uint32_t read_bytes;
+
+	if (page != NULL)
+		return page;
+	vma = vma_lookup(upage);
+	if (vma == NULL)
+		return NULL;
+	delta = upage - vma->start;
+	read_bytes = delta < vma->read_bytes ? vma->read_bytes - delta : 0;
+	if (read_bytes > PGSIZE)
+		read_bytes = PGSIZE;
+	page = page_create(vma->file, vma->offset + delta, upage, read_bytes,
+	                   vma->writable);
+	if (page == NULL)
+		return NULL;
+	page->mapid = vma->mapid;
+	page->mmaped = vma->mapid != MAP_FAILED;
+	ptable_insert(page);
+	return page;
+}
+
+/* START부터 SIZE byte를 영역으로 등록한다.  FILE의 OFS부터
+   READ_BYTES byte를 읽고 나머지는 0으로 채운다.  page는 fault가 날
+   때 만든다.  다른 영역이나 이미 있는 stack page, 모든 process에
+   mapping되는 CLOCK_PAGE와 겹치면 false. */
 bool
-page_load_file(struct page *page)
+vma_add(struct file *file, off_t ofs, void *start, size_t size,
+        uint32_t read_bytes, bool writable, int mapid)
+{
+	struct thread *cur = thread_current();
+	uint8_t *end = (uint8_t *) start + ROUND_UP(size, PGSIZE);
+	uint8_t *stack_bottom = (uint8_t *) PHYS_BASE - STACK_LIMIT;
+	uint8_t *upage;
+	struct list_elem *e;
+	struct vma *vma;
+
+	ASSERT(pg_ofs(start) == 0);
+	if (size == 0 || end <= (uint8_t *) start || end > (uint8_t *) PHYS_BASE)
+		return false;
+	if ((uint8_t *) start <= (uint8_t *) CLOCK_PAGE
+	    && (uint8_t *) CLOCK_PAGE < end)
+		return false;
+	for (e = list_begin(&cur->vma_list); e != list_end(&cur->vma_list);
+	     e = list_next(e))
+	{
+		vma = list_entry(e, struct vma, elem);
+		if (end <= vma->start)
+			break;
+		if ((uint8_t *) start < vma->end)
+			return false;
+	}
+	/* 영역 밖의 page는 stack page뿐이다 */
+	for (upage = (uint8_t *) start > stack_bottom ? start : stack_bottom;
+	     upage < end; upage += PGSIZE)
+		if (ptable_find(upage) != NULL)
+			return false;
+
+	vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return false;
+	vma->start = start;
+	vma->end = end;
+	vma->file = file;
+	vma->offset = ofs;
+	vma->read_bytes = read_bytes;
+	vma->writable = writable;
+	vma->mapid = mapid;
+	list_insert(e, &vma->elem);
+	return true;
+}
+
+/* 현재 thread의 mmap MAPID 영역, 없으면 NULL */
+struct vma *
+vma_find_mapid(int mapid)
+{
+	struct list *vma_list = &thread_current()->vma_list;
+	struct list_elem *e;
+
+	for (e = list_begin(vma_list); e != list_end(vma_list); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+
+		if (vma->mapid == mapid)
+			return vma;
+	}
+	return NULL;
+}
+
+/* PAGE가 zswap이나 swap slot에 맡겨 둔 것을 버린다.  swaped와
+   swap_index는 frame_evict()가 frame_lock 안에서 채우므로 같은 lock
+   안에서 읽는다. */
+static void
+page_discard_swap(struct page *page)
+{
+	size_t slot = BITMAP_ERROR;
+
+	frame_acquire();
+	if (page->swaped && !page->loaded && page->zswap == NULL)
+		slot = page->swap_index;
+	frame_release();
+	zswap_discard(page);
+	if (slot != BITMAP_ERROR)
+		swap_free(slot);
+}
+
+/* VMA와 그 안의 page들을 없앤다.  mmap이면 고친 page를 file에 쓰고
+   file을 닫는다. */
+void
+vma_destroy(struct vma *vma)
 {
 	struct thread *cur = thread_current();
+	uint8_t *upage;
+
+	for (upage = vma->start; upage < vma->end; upage += PGSIZE)
+	{
+		struct page *page = ptable_find(upage);
+
+		if (page == NULL)
+			continue;
+		if (vma->mapid != MAP_FAILED)
+		{
+			void *kpage = NULL;
+
+			/* frame_lock 안에서 busy로 표시하면 그 뒤로는 쫓겨나지
+			   않는다.  이미 쫓겨났다면 frame_evict()가 file에 썼다.
+			   user 주소로 쓰면 file_lock을 잡은 채 fault가 날 수
+			   있으므로 kernel 주소로 쓴다. */
+			frame_acquire();
+			page->busy = true;
+			if (page->loaded)
+				kpage = pagedir_get_page(cur->pagedir, upage);
+			frame_release();
+			if (kpage != NULL && pagedir_is_dirty(cur->pagedir, upage))
+			{
+				filesys_acquire();
+				file_write_at(page->file, kpage, page->read_bytes, page->offset);
+				filesys_release();
+			}
+		}
+		page_discard_swap(page);
+		frame_free(pagedir_get_page(cur->pagedir, upage));
+		pagedir_clear_page(cur->pagedir, upage);
+		hash_delete(&cur->page_table, &page->hash_elem);
+		free(page);
+	}
+	list_remove(&vma->elem);
+	if (vma->mapid != MAP_FAILED)
+	{
+		filesys_acquire();
+		file_close(vma->file);
+		filesys_release();
+	}
+	free(vma);
+}
+
+/* PAGE를 위한 frame을 잡아 file에서 읽고 mapping한다.  실행 file의
+   read-only page는 다른 process가 올려 둔 frame이 있으면 그것을
+   공유한다. */
+static bool
+page_read_file(struct page *page)
+{
+	bool text = !page->writable && page->mapid == MAP_FAILED
+	            && page->read_bytes > 0;
+	if (text && frame_map_text(page))
+	{
+		page->loaded = true;
+		return true;
+	}
 	enum palloc_flags flags = PAL_USER;
 	if (page->read_bytes == 0)
 	{
@@ -117,8 +324,61 @@ page_load_file(struct page *page)
 		frame_free(kpage);
 		return false;
 	}
+	if (text)
+		frame_add_text(kpage, page);
 	page->loaded = true;
+	return true;
+}
+
+/* fault-around: PAGE 뒤로 같은 segment나 mapping에 속하고 아직 안
+   올라온 page들을 같이 올린다.  fault가 직전 window 바로 다음에서
+   나면 순차 접근으로 보고 window를 두 배로 늘리고, 아니면 처음
+   크기로 돌아간다.  빈 frame이 넉넉할 때만 한다. */
+static void
+page_fault_around(struct page *page)
+{
+	struct thread *cur = thread_current();
+	int window, i;
+
+	if (page->upage == cur->fault_next && cur->fault_window > 0)
+		window = cur->fault_window * 2 > FAULT_AROUND_MAX
+		         ? FAULT_AROUND_MAX : cur->fault_window * 2;
+	else
+		window = FAULT_AROUND_MIN;
+	cur->fault_window = window;
+
+	for (i = 1; i < window; i++)
+	{
+		void *upage = (uint8_t *) page->upage + i * PGSIZE;
+		struct page *next = ptable_lookup(upage);
+		bool success;
+
+		if (next == NULL || next->loaded || next->swaped
+		    || next->file != page->file || next->mapid != page->mapid
+		    || next->writable != page->writable
+		    || next->offset != page->offset + i * PGSIZE
+		    || next->read_bytes == 0 || !frame_spare(1))
+			break;
+
+		next->busy = true;
+		success = page_read_file(next);
+		next->busy = false;
+		if (!success)
+			break;
+		fault_around_cnt++;
+	}
+	cur->fault_next = (uint8_t *) page->upage + i * PGSIZE;
+}
+
+bool
+page_load_file(struct page *page)
+{
+	struct thread *cur = thread_current();
+
+	if (!page_read_file(page))
+		return false;
 	pagedir_set_accessed(cur->pagedir, page->upage, true);
+	page_fault_around(page);
 	return true;
 }
 
@@ -140,30 +400,43 @@ page_load_zero(struct page *page)
   return true;
 }
 
-bool
-page_load_swap(struct page *page)
+/* PAGE를 swap에서 읽어 OWNER의 page directory에 mapping한다.
+   fork 중에는 OWNER가 부모다. */
+static bool
+page_swap_in(struct page *page, struct thread *owner)
 {
-	struct thread *cur = thread_current();
 	void *kpage = frame_alloc(PAL_USER, page);
 	if(!kpage) return false;
-	if(!install_page(page->upage, kpage, true))
+	if(pagedir_get_page(owner->pagedir, page->upage) != NULL
+	   || !pagedir_set_page(owner->pagedir, page->upage, kpage, true))
 	{
 	  frame_free(kpage);
 	  return false;
 	}
+	page->page_owner = owner;
 	swap_in(page, kpage);
 	page->swaped = false;
 	page->loaded = true;
-	pagedir_set_dirty(cur->pagedir, page->upage, true);
-  pagedir_set_accessed(cur->pagedir, page->upage, true);
+	pagedir_set_dirty(owner->pagedir, page->upage, true);
+  pagedir_set_accessed(owner->pagedir, page->upage, true);
   return true;
 }
 
+bool
+page_load_swap(struct page *page)
+{
+	return page_swap_in(page, thread_current());
+}
+
 void
 ptable_clear()
 {
 	struct list *page_table = &thread_current()->page_table;
+	struct list *vma_list = &thread_current()->vma_list;
 	hash_destroy(page_table, page_destroy_function);
+	/* mmap 영역은 mmap_clear()가 먼저 정리했다 */
+	while (!list_empty(vma_list))
+		free(list_entry(list_pop_front(vma_list), struct vma, elem));
 }
 
 /* destroy & free elements in page table */
@@ -174,18 +447,148 @@ page_destroy_function (struct hash_elem *e, void *aux UNUSED)
   struct page *page;
   void *kpage;
   page = hash_entry(e, struct page, hash_elem);
+  page_discard_swap(page);
   frame_free(pagedir_get_page(cur->pagedir, page->upage));
   pagedir_clear_page(cur->pagedir, page->upage);
   free(page);
 }
 
+/* fork: 부모의 PAGE를 자식의 COPY로 복제한다.  올라와 있는 page는
+   frame을 공유하고, swap에 있는 page는 부모 쪽으로 먼저 읽어 온 뒤
+   공유한다.  나머지는 COPY도 file이나 0에서 lazy하게 올라온다. */
+static bool
+page_fork(struct thread *parent, struct page *page, struct page *copy)
+{
+	bool success;
+
+	page->busy = true;
+	for (;;)
+	{
+		if (frame_share(page, copy))
+		{
+			success = true;
+			break;
+		}
+		/* frame_share()가 frame_lock 안에서 본 뒤로는, busy라서
+		   page 상태가 바뀌지 않는다. */
+		if (page->loaded || !page->swaped)
+		{
+			success = !page->loaded;
+			break;
+		}
+		if (!page_swap_in(page, parent))
+		{
+			success = false;
+			break;
+		}
+	}
+	page->busy = false;
+	return success;
+}
+
+/* PARENT의 영역과 page table을 현재 thread로 복제한다.  mmap은
+   file과 직접 이어져 있어 공유하지 않는다.  부모가 고친 mmap page를
+   file에 먼저 쓰고, 자식은 다시 연 file에서 lazy하게 읽는다. */
+bool
+ptable_fork(struct thread *parent)
+{
+	struct thread *cur = thread_current();
+	struct hash_iterator i;
+	struct list_elem *e;
+
+	for (e = list_begin(&parent->vma_list); e != list_end(&parent->vma_list);
+	     e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		struct vma *copy = malloc(sizeof *copy);
+
+		if (copy == NULL)
+			return false;
+		*copy = *vma;
+		if (vma->mapid != MAP_FAILED)
+		{
+			filesys_acquire();
+			copy->file = file_reopen(vma->file);
+			filesys_release();
+			if (copy->file == NULL)
+			{
+				free(copy);
+				return false;
+			}
+		}
+		else if (vma->file == parent->executable)
+			copy->file = cur->executable;
+		list_push_back(&cur->vma_list, &copy->elem);
+	}
+
+	hash_first(&i, &parent->page_table);
+	while (hash_next(&i))
+	{
+		struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+		struct page *copy;
+
+		if (page->mapid != MAP_FAILED)
+		{
+			void *kpage;
+
+			page->busy = true;
+			kpage = pagedir_get_page(parent->pagedir, page->upage);
+			if (kpage != NULL && pagedir_is_dirty(parent->pagedir, page->upage))
+			{
+				filesys_acquire();
+				file_write_at(page->file, kpage, page->read_bytes, page->offset);
+				filesys_release();
+				pagedir_set_dirty(parent->pagedir, page->upage, false);
+			}
+			page->busy = false;
+			continue;
+		}
+		copy = malloc(sizeof *copy);
+		if (copy == NULL)
+			return false;
+		*copy = *page;
+		if (copy->file == parent->executable)
+			copy->file = cur->executable;
+		copy->page_owner = cur;
+		copy->loaded = false;
+		copy->swaped = false;
+		copy->busy = false;
+		copy->zswap = NULL;
+		copy->cow_next = NULL;
+		if (!ptable_insert(copy))
+		{
+			free(copy);
+			return false;
+		}
+		if (!page_fork(parent, page, copy))
+			return false;
+	}
+	return true;
+}
+
+/* page 통계 출력 */
+void
+page_print_stats(void)
+{
+	printf("Page: %lld pages mapped ahead by fault-around\n",
+	       fault_around_cnt);
+}
+
+/* WRITE는 fault가 쓰기였는지.  0으로 채울 page를 읽기만 하면
+   frame을 잡지 않고 공유 zero frame을 mapping한다. */
 bool
-page_load(struct page *page)
+page_load(struct page *page, bool write)
 {
   if(page->loaded)
     return false;
   if(page->swaped)
     return page_load_swap(page);
+  if(!write && (page->file == NULL || page->read_bytes == 0)
+     && page->mapid == MAP_FAILED && frame_map_zero(page))
+  {
+    page->loaded = true;
+    return true;
+  }
   if(page->file)
     return page_load_file(page);
   else
@@ -211,6 +614,8 @@ stack_growth(void* fault_addr)
     s_page->swaped = false;
     s_page->mapid = -1;
     s_page->busy = true;
+    s_page->zswap = NULL;
+    s_page->cow_next = NULL;
     uint8_t *tmp_kpage = frame_alloc(PAL_USER | PAL_ZERO, s_page);
     if (!tmp_kpage)
     {
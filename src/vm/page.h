@@ -12,11 +12,24 @@
 
 #define STACK_LIMIT 8 * 1024 * 1024
 
+/* 연속된 user 가상 주소 영역 하나 (실행 file의 segment나 mmap).
+   struct page는 영역 안의 page에 처음 fault가 날 때 만들어진다. */
+struct vma
+{
+	uint8_t *start;		/* 첫 page, page 단위로 정렬 */
+	uint8_t *end;		/* 마지막 page 다음 */
+	struct file *file;	/* 읽어 올 file */
+	off_t offset;		/* start에 해당하는 file 위치 */
+	uint32_t read_bytes;	/* file에서 읽을 byte 수, 나머지는 0 */
+	bool writable;
+	int mapid;		/* mmap이면 mapid, 아니면 MAP_FAILED */
+	struct list_elem elem;	/* thread의 vma_list, start 순 */
+};
+
 struct page
 {
 	void *upage;	/* Virtual address */
 	struct hash_elem hash_elem;	/* Hash element */
-	struct list_elem list_elem;
 	struct thread *page_owner;
 	struct file *file;
 	int32_t offset;
@@ -28,17 +41,26 @@ struct page
 	int mapid;
 	size_t swap_index;
 	bool busy;
+	struct zswap_entry *zswap;	/* zswap에 맡긴 내용, 없으면 NULL */
+	struct page *cow_next;	/* 같은 frame을 공유하는 다음 page */
 };
 
 void ptable_init(struct hash *ptable);
 struct page* page_create(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, bool writable);
 bool ptable_insert(struct page *page);
 struct page* ptable_lookup(void* addr);
+struct page *ptable_find(void *addr);
+bool vma_add(struct file *file, off_t ofs, void *start, size_t size,
+             uint32_t read_bytes, bool writable, int mapid);
+struct vma *vma_find_mapid(int mapid);
+void vma_destroy(struct vma *vma);
 bool page_load_file(struct page *page);
 bool page_load_zero (struct page *page);
 bool page_laod_swap (struct page *page);
 void ptable_clear(void);
-bool page_load(struct page *page);
+bool page_load(struct page *page, bool write);
+bool ptable_fork(struct thread *parent);
 bool stack_growth(void* fault_addr);
+void page_print_stats(void);
 
 #endif /* vm/page.h */
\ No newline at end of file
@@ -1,12 +1,25 @@
 #include "vm/swap.h"
+#include <bitmap.h>
 #include "vm/page.h"
 #include "vm/frame.h"
+#include "vm/zswap.h"
 #include "threads/thread.h"
 #include "threads/synch.h"
 #include "devices/disk.h"
 #include "threads/vaddr.h"
 #include "userprog/pagedir.h"
 
+/* page 하나를 담는 disk sector 수 */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+/* swap table: swap disk의 slot마다 1 bit, 사용 중이면 true.
+   slot N은 sector N * SECTORS_PER_PAGE부터 시작한다. */
+static struct bitmap *swap_table;
+static struct lock swap_table_lock;
+
+/* 다음 swap_out이 빈 slot을 찾기 시작할 위치 (next fit) */
+static size_t swap_hint;
+
 void 
 swap_acquire(void)
 {
@@ -24,88 +37,97 @@ void
 swap_init(void)
 {
 	struct disk *disk = disk_get(1, 1);
-	list_init(&swap_table);
+	size_t slot_cnt = disk != NULL ? disk_size(disk) / SECTORS_PER_PAGE : 0;
+
 	lock_init(&swap_table_lock);
-	int i;
-	for(i = 0; i < (disk_size(disk) * DISK_SECTOR_SIZE / PGSIZE); i++)
-	{
-		struct swap *swap_space  = malloc(sizeof(struct swap));
-		swap_space->is_empty = true;
-		swap_space->table_index = i + 1;
-		if(swap_space == NULL) return;
-		list_push_back(&swap_table, &swap_space->elem);
-	}
-	return;
+	swap_table = bitmap_create(slot_cnt);
+	if (swap_table == NULL)
+		PANIC("swap table: out of memory");
+	swap_hint = 0;
 }
 
-
+/* FRAME_ADDR의 page를 빈 slot에 쓰고 slot 번호를 return.
+   빈 slot이 없으면 BITMAP_ERROR. */
 size_t
 swap_out(void *frame_addr)
+{
+	size_t slot;
+
+	if (!swap_out_cluster(&frame_addr, &slot, 1))
+		return BITMAP_ERROR;
+	return slot;
+}
+
+/* PAGES의 CNT개 page를 연속된 CNT개의 slot에 disk request 한 번으로
+   쓰고, 각 page의 slot 번호를 SLOTS에 저장한다.  연속된 빈 slot이
+   없으면 아무것도 쓰지 않고 false. */
+bool
+swap_out_cluster(void *pages[], size_t slots[], size_t cnt)
 {
 	struct disk *disk_block = disk_get(1, 1);
-	size_t table_index;
-	swap_acquire();
-	struct list_elem *e;
-	for(e = list_begin(&swap_table); e != list_end(&swap_table); e = list_next(e))
-	{
-		struct swap *swap_elem = list_entry(e, struct swap, elem);
-		if(swap_elem->is_empty)
-		{
-			swap_elem->is_empty = false;
-			table_index = swap_elem->table_index;
-			break;
-		}
-	}
-	if(table_index == NULL || table_index == list_size(&swap_table))
-	{
-		swap_release();
-		return -1;
-	}
+	const void *sectors[SWAP_CLUSTER_MAX * SECTORS_PER_PAGE];
+	size_t first, i;
 	disk_sector_t disk_sector;
-	for(disk_sector = 0; disk_sector < (PGSIZE / DISK_SECTOR_SIZE); disk_sector++)
-	{
-		disk_write(disk_block, table_index * (PGSIZE / DISK_SECTOR_SIZE) + disk_sector, frame_addr + disk_sector * DISK_SECTOR_SIZE);
-	}
+
+	ASSERT(cnt > 0 && cnt <= SWAP_CLUSTER_MAX);
+
+	/* slot만 잡고 lock은 바로 놓는다.  쓰는 동안 다른 thread도
+	   swap을 쓸 수 있다. */
+	swap_acquire();
+	first = bitmap_scan_and_flip(swap_table, swap_hint, cnt, false);
+	if (first == BITMAP_ERROR)
+		first = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+	if (first != BITMAP_ERROR)
+		swap_hint = first + cnt;
 	swap_release();
-	return table_index;
-}
+	if (first == BITMAP_ERROR)
+		return false;
 
-struct swap *
-swap_get_from_index(size_t swap_index)
-{
-	if(list_empty(&swap_table))
-	{
-		return NULL;
-	}
-	struct list_elem *e;
-	struct list_elem *next;
-	for(e = list_begin(&swap_table); e != list_end(&swap_table);)
+	for (i = 0; i < cnt; i++)
 	{
-		next = list_next(e);
-		struct swap *tmp_swap = list_entry(e, struct swap, elem);
-		if(tmp_swap->table_index == swap_index)
-			return tmp_swap;
-		e = next;
+		slots[i] = first + i;
+		for (disk_sector = 0; disk_sector < SECTORS_PER_PAGE; disk_sector++)
+			sectors[i * SECTORS_PER_PAGE + disk_sector] = (uint8_t *) pages[i] + disk_sector * DISK_SECTOR_SIZE;
 	}
-	return NULL;
+	disk_write_multiple(disk_block, first * SECTORS_PER_PAGE, sectors, cnt * SECTORS_PER_PAGE);
+	return true;
 }
 
+/* PAGE의 swap slot을 ADDR로 읽어오고 slot을 비운다. */
 void
 swap_in(struct page *page, void *addr)
 {
 	struct disk *disk_block = disk_get(1, 1);
+	size_t slot = page->swap_index;
+	disk_sector_t disk_sector;
+
+	/* zswap에 있으면 disk I/O 없이 */
+	if (page->zswap != NULL)
+	{
+		zswap_load(page, addr);
+		return;
+	}
+
 	swap_acquire();
-	struct swap *swap_elem = swap_get_from_index(page->swap_index);
-	if (!swap_elem || swap_elem->is_empty)
+	if (slot >= bitmap_size(swap_table) || !bitmap_test(swap_table, slot))
 	{
 		swap_release();
 		return;
 	}
-	swap_elem->is_empty = true;
-	disk_sector_t disk_sector;
-	for (disk_sector = 0; disk_sector < (PGSIZE / DISK_SECTOR_SIZE); disk_sector++) 
+	for (disk_sector = 0; disk_sector < SECTORS_PER_PAGE; disk_sector++) 
 	{
-		disk_read(disk_block, page->swap_index * PGSIZE / DISK_SECTOR_SIZE + disk_sector, addr + disk_sector * DISK_SECTOR_SIZE);
+		disk_read(disk_block, slot * SECTORS_PER_PAGE + disk_sector, addr + disk_sector * DISK_SECTOR_SIZE);
 	}
+	bitmap_reset(swap_table, slot);
+	swap_release();
+}
+
+/* SLOT을 비운다.  swap에 나간 page가 다시 읽히지 않고 없어질 때 부른다. */
+void
+swap_free(size_t slot)
+{
+	swap_acquire();
+	if (slot < bitmap_size(swap_table))
+		bitmap_reset(swap_table, slot);
 	swap_release();
 }
@@ -1,28 +1,19 @@
 #ifndef VM_SWAP_H
 #define VM_SWAP_H
 
-#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include "vm/page.h"
 
-struct list swap_table;
-struct lock swap_table_lock;
-
-static bool swap_init_check = false;
-
-struct swap
-{
-	struct list_elem elem;
-	bool is_empty;
-	size_t table_index;
-};
+/* swap_out_cluster()가 한 번에 쓰는 최대 page 수 */
+#define SWAP_CLUSTER_MAX 8
 
 void swap_acquire(void);
 void swap_release(void);
 void swap_init(void);
 size_t swap_out(void *upage);
-struct swap * swap_get_from_index(size_t swap_index);
+bool swap_out_cluster(void *pages[], size_t slots[], size_t cnt);
 void swap_in(struct page *page, void *addr);
+void swap_free(size_t slot);
 
-#endif /* vm/swap.h */
\ No newline at end of file
+#endif /* vm/swap.h */
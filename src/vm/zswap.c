@@ -0,0 +1,251 @@
+#include "vm/zswap.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* 압축된 swap cache.
+
+   frame_evict()가 swap으로 보낼 anonymous page는 먼저 여기에
+   맡겨 본다.  0으로만 채워진 page는 공간도 I/O도 쓰지 않고,
+   나머지는 zero-run 압축을 해서 kernel heap에 둔다.  pool이 차거나
+   잘 압축되지 않는 page만 swap disk로 간다.
+
+   압축 형식은 32-bit word 단위의 token 열이다.  token 하나는
+   0인 word 수와 그 뒤에 그대로 복사할 word 수, 그리고 그 word들로
+   이루어진다. */
+
+#define PAGE_WORDS (PGSIZE / sizeof (uint32_t))
+
+/* token header */
+struct zswap_token
+{
+	uint16_t zero_words;	/* 0인 word 수 */
+	uint16_t literal_words;	/* 뒤따르는 word 수 */
+};
+
+/* 압축된 page 하나 */
+struct zswap_entry
+{
+	size_t len;		/* data의 byte 수 */
+	uint8_t data[];
+};
+
+/* malloc()이 arena에서 내주는 가장 큰 block.  이보다 크면 page를
+   통째로 받으므로 압축한 의미가 없다. */
+#define ZSWAP_BLOCK_MAX 1024
+
+/* 압축 결과가 이보다 크면 disk로 보낸다.  entry 전체가 block 하나에
+   들어가야 한다. */
+#define ZSWAP_MAX_LEN (ZSWAP_BLOCK_MAX - sizeof (struct zswap_entry))
+
+/* zero page는 모두 이것 하나를 가리킨다 */
+static struct zswap_entry zero_entry;
+
+size_t zswap_pages;
+
+static struct lock zswap_lock;
+static size_t zswap_bytes;	/* pool이 heap에서 받은 block의 byte 수 */
+
+/* 통계 */
+static long long zero_cnt;	/* zero page로 저장한 수 */
+static long long store_cnt;	/* 압축해서 저장한 수 */
+static long long reject_cnt;	/* 압축이 잘 안 돼서 disk로 보낸 수 */
+static long long full_cnt;	/* pool이 차서 disk로 보낸 수 */
+static long long load_cnt;	/* 다시 읽어 온 수 */
+static unsigned long long stored_bytes;	/* 압축 후 byte 수의 합 */
+
+void
+zswap_init(void)
+{
+	lock_init(&zswap_lock);
+	zswap_bytes = 0;
+}
+
+/* LEN byte짜리 entry에 malloc()이 실제로 내주는 block의 크기.
+   block은 16 byte부터 2의 거듭제곱 크기이다. */
+static size_t
+entry_size(size_t len)
+{
+	size_t size = 16;
+
+	while (size < sizeof (struct zswap_entry) + len)
+		size *= 2;
+	ASSERT(size <= ZSWAP_BLOCK_MAX);
+	return size;
+}
+
+/* PAGE가 0으로만 채워져 있으면 true */
+static bool
+is_zero_page(const uint32_t *page)
+{
+	size_t i;
+
+	for (i = 0; i < PAGE_WORDS; i++)
+		if (page[i] != 0)
+			return false;
+	return true;
+}
+
+/* SRC page를 DST에 압축하고 byte 수를 return.  DST_SIZE를 넘으면
+   중간에 멈추고 DST_SIZE + 1을 return. */
+static size_t
+compress(const uint32_t *src, uint8_t *dst, size_t dst_size)
+{
+	size_t i = 0, len = 0;
+
+	while (i < PAGE_WORDS)
+	{
+		struct zswap_token token;
+		size_t start;
+
+		start = i;
+		while (i < PAGE_WORDS && src[i] == 0 && i - start < UINT16_MAX)
+			i++;
+		token.zero_words = i - start;
+
+		start = i;
+		while (i < PAGE_WORDS && (src[i] != 0 || (i + 1 < PAGE_WORDS && src[i + 1] != 0))
+		       && i - start < UINT16_MAX)
+			i++;
+		token.literal_words = i - start;
+
+		if (len + sizeof token + token.literal_words * sizeof *src > dst_size)
+			return dst_size + 1;
+		memcpy(dst + len, &token, sizeof token);
+		len += sizeof token;
+		memcpy(dst + len, src + start, token.literal_words * sizeof *src);
+		len += token.literal_words * sizeof *src;
+	}
+	return len;
+}
+
+/* SRC의 LEN byte를 풀어서 DST page를 채운다. */
+static void
+decompress(const uint8_t *src, size_t len, uint32_t *dst)
+{
+	const uint8_t *end = src + len;
+	size_t i = 0;
+
+	while (src < end)
+	{
+		struct zswap_token token;
+
+		memcpy(&token, src, sizeof token);
+		src += sizeof token;
+		ASSERT(i + token.zero_words + token.literal_words <= PAGE_WORDS);
+		memset(dst + i, 0, token.zero_words * sizeof *dst);
+		i += token.zero_words;
+		memcpy(dst + i, src, token.literal_words * sizeof *dst);
+		src += token.literal_words * sizeof *dst;
+		i += token.literal_words;
+	}
+	ASSERT(i == PAGE_WORDS);
+}
+
+/* PAGE의 내용 KPAGE를 pool에 맡긴다.  성공하면 PAGE->zswap이
+   채워지고 true, disk로 보내야 하면 false. */
+bool
+zswap_store(struct page *page, const void *kpage)
+{
+	static uint8_t buf[ZSWAP_MAX_LEN];
+	struct zswap_entry *entry;
+	size_t len;
+
+	ASSERT(page->zswap == NULL);
+
+	lock_acquire(&zswap_lock);
+	if (is_zero_page(kpage))
+	{
+		zero_cnt++;
+		page->zswap = &zero_entry;
+		lock_release(&zswap_lock);
+		return true;
+	}
+	if (zswap_pages == 0)
+	{
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	len = compress(kpage, buf, sizeof buf);
+	if (len > sizeof buf)
+	{
+		reject_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	if (zswap_bytes + entry_size(len) > zswap_pages * PGSIZE
+	    || (entry = malloc(sizeof *entry + len)) == NULL)
+	{
+		full_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	entry->len = len;
+	memcpy(entry->data, buf, len);
+	zswap_bytes += entry_size(len);
+	store_cnt++;
+	stored_bytes += len;
+	page->zswap = entry;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* PAGE를 pool에서 KPAGE로 읽어 오고 pool에서 지운다. */
+void
+zswap_load(struct page *page, void *kpage)
+{
+	struct zswap_entry *entry = page->zswap;
+
+	ASSERT(entry != NULL);
+
+	if (entry == &zero_entry)
+		memset(kpage, 0, PGSIZE);
+	else
+		decompress(entry->data, entry->len, kpage);
+
+	lock_acquire(&zswap_lock);
+	load_cnt++;
+	lock_release(&zswap_lock);
+	zswap_discard(page);
+}
+
+/* PAGE가 pool에 맡겨 둔 것이 있으면 버린다. */
+void
+zswap_discard(struct page *page)
+{
+	struct zswap_entry *entry = page->zswap;
+
+	if (entry == NULL)
+		return;
+	page->zswap = NULL;
+	if (entry == &zero_entry)
+		return;
+
+	lock_acquire(&zswap_lock);
+	zswap_bytes -= entry_size(entry->len);
+	lock_release(&zswap_lock);
+	free(entry);
+}
+
+/* zswap 통계 출력 */
+void
+zswap_print_stats(void)
+{
+	long long saved = zero_cnt + store_cnt;
+
+	printf("Zswap: %lld zero pages, %lld compressed, %lld rejected, "
+	       "%lld over limit, %lld loaded\n",
+	       zero_cnt, store_cnt, reject_cnt, full_cnt, load_cnt);
+	if (store_cnt > 0)
+		printf("Zswap: compression ratio %llu.%02llu, "
+		       "%lld disk page writes avoided\n",
+		       store_cnt * PGSIZE / stored_bytes,
+		       store_cnt * PGSIZE * 100 / stored_bytes % 100, saved);
+	else
+		printf("Zswap: %lld disk page writes avoided\n", saved);
+}
@@ -0,0 +1,17 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vm/page.h"
+
+/* 압축된 page를 담는 pool의 크기 (page 단위, 0이면 끔) */
+extern size_t zswap_pages;
+
+void zswap_init(void);
+bool zswap_store(struct page *page, const void *kpage);
+void zswap_load(struct page *page, void *kpage);
+void zswap_discard(struct page *page);
+void zswap_print_stats(void);
+
+#endif /* vm/zswap.h */